@@ -0,0 +1,42 @@
+/* Copyright (c) 2006-2014 Jonas Fonseca <jonas.fonseca@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef TIG_CACHE_H
+#define TIG_CACHE_H
+
+#include "tig/tig.h"
+
+/*
+ * Cache files stored in the git directory.
+ */
+
+struct cache_file {
+	const char *data;
+	size_t size;
+};
+
+bool cache_map(struct cache_file *file, const char *name);
+void cache_unmap(struct cache_file *file);
+
+struct cache_writer {
+	FILE *file;
+	char path[SIZEOF_STR];
+	char tmp[SIZEOF_STR];
+};
+
+bool cache_write_begin(struct cache_writer *writer, const char *name);
+bool cache_write(struct cache_writer *writer, const void *data, size_t size);
+bool cache_write_end(struct cache_writer *writer, bool commit);
+
+#endif
+/* vim: set ts=8 sw=8 noexpandtab: */
@@ -33,6 +33,10 @@ struct menu_item {
 char *read_prompt(const char *prompt);
 bool prompt_yesno(const char *prompt);
 bool prompt_menu(const char *prompt, const struct menu_item *items, int *selected);
+/* Returned by get_input() instead of a key when the repository has
+ * changed. Curses returns no negative keys besides ERR. */
+#define KEY_REPO_CHANGED	(-2)
+
 int get_input(int prompt_position, struct key_input *input, bool modifiers);
 
 void report(const char *msg, ...) PRINTF_LIKE(1, 2);
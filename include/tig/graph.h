@@ -15,6 +15,7 @@
 #define TIG_GRAPH_H
 
 #include "compat/hashtab.h"
+#include "tig/util.h"
 
 #define GRAPH_COLORS	7
 
@@ -50,12 +51,12 @@ struct graph_symbol {
 
 struct graph_canvas {
 	size_t size;			/* The width of the graph array. */
-	struct graph_symbol *symbols;	/* Symbols for this row. */
+	const struct graph_symbol *symbols; /* Symbols for this row, shared with equal rows. */
 };
 
 struct graph_column {
 	struct graph_symbol symbol;
-	char id[SIZEOF_REV];		/* Parent SHA1 ID. */
+	const char *id;			/* Parent SHA1 ID, interned in the graph. */
 };
 
 struct graph_row {
@@ -76,11 +77,16 @@ struct graph {
 	size_t position;
 	size_t prev_position;
 	size_t expanded;
-	char id[SIZEOF_REV];
+	const char *id;
 	struct graph_canvas *canvas;
 	struct colors colors;
 	bool has_parents;
 	bool is_boundary;
+	struct graph_symbol *symbols;	/* Symbols of the row being rendered. */
+	size_t symbols_size;
+	htab_t canvases;		/* Distinct rows of symbols, in the arena. */
+	struct arena *arena;		/* Storage for the rows of symbols. */
+	struct string_pool ids;		/* IDs of the columns, compared by pointer. */
 };
 
 void done_graph(struct graph *graph);
@@ -90,9 +96,14 @@ bool graph_add_commit(struct graph *graph, struct graph_canvas *canvas,
 		      const char *id, const char *parents, bool is_boundary);
 struct graph_column *graph_add_parent(struct graph *graph, const char *parent);
 
-const char *graph_symbol_to_ascii(struct graph_symbol *symbol);
-const char *graph_symbol_to_utf8(struct graph_symbol *symbol);
-const chtype *graph_symbol_to_chtype(struct graph_symbol *symbol);
+size_t graph_state_size(struct graph *graph);
+bool graph_get_state(struct graph *graph, void *state);
+bool graph_set_state(struct graph *graph, const void *state);
+bool graph_check_state(const void *state, size_t size);
+
+const char *graph_symbol_to_ascii(const struct graph_symbol *symbol);
+const char *graph_symbol_to_utf8(const struct graph_symbol *symbol);
+const chtype *graph_symbol_to_chtype(const struct graph_symbol *symbol);
 
 #endif
 
@@ -46,6 +46,13 @@ enum io_type {
 	IO_AP,			/* Append fork+exec output to file. */
 };
 
+struct buffer {
+	char *data;
+	size_t size;
+};
+
+struct arena;
+
 struct io {
 	int pipe;		/* Pipe end for reading or writing. */
 	pid_t pid;		/* PID of spawned process. */
@@ -54,8 +61,14 @@ struct io {
 	size_t bufalloc;	/* Allocated buffer size. */
 	size_t bufsize;		/* Buffer content size. */
 	char *bufpos;		/* Current buffer position. */
+	struct arena *arena;	/* Memory to keep read lines in, if any. */
 	unsigned int eof:1;	/* Has end of file been reached. */
+	unsigned int full_read:1; /* Did the last read fill the buffer. */
 	int status:8;		/* Status exit code. */
+	unsigned long reads;	/* Statistics for tracing. */
+	unsigned long read_bytes;
+	unsigned long moves;
+	unsigned long moved_bytes;
 };
 
 typedef int (*io_read_fn)(char *, size_t, char *, size_t, void *data);
@@ -73,8 +86,10 @@ int io_error(struct io *io);
 char * io_strerror(struct io *io);
 bool io_can_read(struct io *io, bool can_block);
 ssize_t io_read(struct io *io, void *buf, size_t bufsize);
+bool io_get_buffer(struct io *io, struct buffer *buf, int c, bool can_read);
 char * io_get(struct io *io, int c, bool can_read);
 bool io_write(struct io *io, const void *buf, size_t bufsize);
+ssize_t io_write_some(struct io *io, const void *buf, size_t bufsize);
 bool io_printf(struct io *io, const char *fmt, ...) PRINTF_LIKE(2, 3);
 bool io_read_buf(struct io *io, char buf[], size_t bufsize);
 bool io_run_buf(const char **argv, char buf[], size_t bufsize);
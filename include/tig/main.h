@@ -18,24 +18,39 @@
 #include "tig/graph.h"
 #include "tig/util.h"
 
+struct main_lanes;
+
 struct commit {
 	char id[SIZEOF_REV];		/* SHA1 ID. */
 	const struct ident *author;	/* Author of the commit. */
 	struct time time;		/* Date from the author ident. */
 	struct graph_canvas graph;	/* Ancestry chain graphics. */
+	const char *parents;		/* Parent IDs, each preceded by a space. */
+	const struct main_lanes *lanes;	/* Graph lane state above the commit. */
+	bool is_boundary;
 	char title[1];			/* First line of the commit message. */
 };
 
+struct main_cache;
+
 struct main_state {
-	struct graph graph;
 	struct commit current;
 	char **reflog;
 	size_t reflogs;
 	int reflog_width;
 	char reflogmsg[SIZEOF_STR / 2];
+	char jump_id[SIZEOF_REV];	/* Commit to jump to once loaded. */
 	bool in_header;
 	bool added_changes_commits;
 	bool with_graph;
+	bool has_parents;		/* Are parents listed on commit lines? */
+	size_t graph_lines;		/* Lines with rendered graph rows. */
+	htab_t graph_canvases;		/* Rows of graph symbols in the view's arena. */
+	size_t changes_lines;		/* Lines up to the last changes commit. */
+	size_t cached_lanes_line;	/* Line where cached lane states match. */
+	bool cached_lanes_match;	/* Can cached lane states be used? */
+	bool commits_loaded;		/* Have all commits been added? */
+	struct main_cache *cache;	/* Commit cache used while loading. */
 };
 
 bool main_read(struct view *view, char *line);
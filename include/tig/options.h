@@ -35,9 +35,11 @@
 	_(ignore_space,			enum ignore_space) \
 	_(line_graphics,		enum graphic) \
 	_(line_number_interval,		int) \
+	_(main_cache,			bool) \
 	_(mouse,			bool) \
 	_(mouse_scroll,			int) \
 	_(read_git_colors,		bool) \
+	_(refresh_mode,			enum refresh_mode) \
 	_(scale_vsplit_view,		double) \
 	_(show_author,			enum author) \
 	_(show_changes,			bool) \
@@ -52,6 +54,7 @@
 	_(show_rev_graph,		bool) \
 	_(split_view_height,		double) \
 	_(status_untracked_dirs,	bool) \
+	_(status_watch,			bool) \
 	_(tab_size,			int) \
 	_(title_overflow,		int) \
 	_(vertical_split,		enum vertical_split) \
@@ -37,6 +37,9 @@ extern const char *update_index_argv[];
 
 bool status_update_file(struct status *status, enum line_type type);
 bool status_update_files(struct view *view, struct line *line);
+bool status_update_wait(int *fd);
+void status_update_continue(void);
+bool status_update_finish(void);
 
 bool status_revert(struct status *status, enum line_type type, bool has_none);
 bool status_exists(struct view *view, struct status *status, enum line_type type);
@@ -74,6 +74,8 @@ void string_ncopy_do(char *dst, size_t dstlen, const char *src, size_t srclen);
 
 void string_copy_rev(char *dst, const char *src);
 void string_copy_rev_from_commit_line(char *dst, const char *src);
+bool string_rev_to_id(unsigned char *id, const char *rev);
+void string_id_to_rev(char *rev, const unsigned char *id);
 
 #define string_rev_is_null(rev) !strncmp(rev, NULL_ID, STRING_SIZE(NULL_ID))
 
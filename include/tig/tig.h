@@ -47,10 +47,13 @@
 #include <sys/wait.h>
 #include <sys/stat.h>
 #include <sys/select.h>
+#include <sys/mman.h>
+#include <poll.h>
 #include <unistd.h>
 #include <sys/time.h>
 #include <time.h>
 #include <fcntl.h>
+#include <dirent.h>
 
 #include <regex.h>
 
@@ -101,6 +104,7 @@
 #define SIZEOF_STR	1024	/* Default string size. */
 #define SIZEOF_REF	256	/* Size of symbolic or SHA1 ID. */
 #define SIZEOF_REV	41	/* Holds a SHA-1 and an ending NUL. */
+#define SIZEOF_ID	20	/* Holds a binary SHA-1. */
 
 /* This color name can be used to refer to the default term colors. */
 #define COLOR_DEFAULT	(-1)
@@ -66,6 +66,12 @@ bool map_enum_do(const struct enum_map_entry *map, size_t map_size, int *value,
 
 DEFINE_ENUM(vertical_split, VERTICAL_SPLIT_ENUM);
 
+#define REFRESH_MODE_ENUM(_) \
+	_(REFRESH_MODE, MANUAL), \
+	_(REFRESH_MODE, AUTO)
+
+DEFINE_ENUM(refresh_mode, REFRESH_MODE_ENUM);
+
 #define GRAPHIC_ENUM(_) \
 	_(GRAPHIC, ASCII), \
 	_(GRAPHIC, DEFAULT), \
@@ -16,6 +16,7 @@
 
 #include "tig/tig.h"
 #include "tig/types.h"
+#include "compat/hashtab.h"
 
 /*
  * Error handling.
@@ -105,12 +106,26 @@ const char *mkmode(mode_t mode);
  * Allocation helper.
  */
 
+/* Round the number of chunks up to a power of two so that arrays grown
+ * one item at a time are reallocated a logarithmic number of times. */
+static inline size_t
+alloc_chunks(size_t chunks)
+{
+	size_t alloc = 1;
+
+	if (!chunks)
+		return 0;
+	while (alloc < chunks)
+		alloc <<= 1;
+	return alloc;
+}
+
 #define DEFINE_ALLOCATOR(name, type, chunk_size)				\
 static type *									\
 name(type **mem, size_t size, size_t increase)					\
 {										\
-	size_t num_chunks = (size + chunk_size - 1) / chunk_size;		\
-	size_t num_chunks_new = (size + increase + chunk_size - 1) / chunk_size;\
+	size_t num_chunks = alloc_chunks((size + chunk_size - 1) / chunk_size);	\
+	size_t num_chunks_new = alloc_chunks((size + increase + chunk_size - 1) / chunk_size);\
 	type *tmp = *mem;							\
 										\
 	if (mem == NULL || num_chunks != num_chunks_new) {			\
@@ -131,5 +146,40 @@ name(type **mem, size_t size, size_t increase)					\
 	return tmp;								\
 }
 
+/*
+ * Arena allocator.
+ *
+ * Hands out zeroed memory from large chunks, which can only be released
+ * all at once. Use it for data sharing the same lifetime, e.g. the lines
+ * of a view, to avoid a malloc() and free() per item.
+ */
+
+struct arena_chunk;
+
+struct arena {
+	struct arena_chunk *chunks;
+	char *pos, *end;
+};
+
+void *arena_alloc(struct arena *arena, size_t size);
+char *arena_strndup(struct arena *arena, const char *str, size_t len);
+void arena_free(struct arena *arena);
+
+/*
+ * String interning.
+ *
+ * Returns a single shared copy for each distinct string, so that
+ * interned strings can be compared by pointer. The copies live as long
+ * as the pool.
+ */
+
+struct string_pool {
+	htab_t map;
+	struct arena arena;
+};
+
+const char *string_pool_intern(struct string_pool *pool, const char *str, size_t len);
+void string_pool_free(struct string_pool *pool);
+
 #endif
 /* vim: set ts=8 sw=8 noexpandtab: */
@@ -17,8 +17,10 @@
 #include "tig/tig.h"
 #include "tig/argv.h"
 #include "tig/io.h"
+#include "tig/util.h"
 #include "tig/line.h"
 #include "tig/keys.h"
+#include "tig/watch.h"
 
 struct view_ops;
 
@@ -52,9 +54,13 @@ enum view_flag {
 	VIEW_STATUS_LIKE	= 1 << 12,
 	VIEW_REFRESH		= 1 << 13,
 	VIEW_CUSTOM_DIGITS	= 1 << 14,
+	VIEW_NUL_SEPARATED	= 1 << 15,
+	VIEW_KEEP_TEXT		= 1 << 16,
 };
 
 #define view_has_flags(view, flag)	((view)->ops->flags & (flag))
+#define view_can_refresh(view) \
+	(view_has_flags(view, VIEW_REFRESH) && !(view)->unrefreshable)
 
 struct position {
 	unsigned long offset;	/* Offset of the window top */
@@ -62,6 +68,11 @@ struct position {
 	unsigned long lineno;	/* Current line number */
 };
 
+struct line_id {
+	const char *id;		/* ID of the line, e.g. a commit ID. */
+	unsigned long lineno;	/* Index of the line in the view. */
+};
+
 struct view {
 	const char *name;	/* View name */
 
@@ -91,8 +102,16 @@ struct view {
 	/* Buffering */
 	size_t lines;		/* Total number of lines */
 	struct line *line;	/* Line index */
+	size_t line_alloc;	/* Allocated size of the line index */
+	struct arena arena;	/* Memory used for line data. */
+	struct buffer read;	/* Line being read, if it is kept in the arena. */
 	unsigned int digits;	/* Number of digits in the lines member. */
 
+	/* Sorted index of line IDs used by find_line_by_id(). */
+	struct line_id *ids;
+	size_t ids_size;	/* Number of entries in the ID index */
+	size_t ids_lines;	/* Number of lines covered by the ID index */
+
 	/* Number of lines with custom status, not to be counted in the
 	 * view title. */
 	unsigned int custom_lines;
@@ -113,6 +132,7 @@ struct view {
 	time_t update_secs;
 	struct encoding *encoding;
 	bool unrefreshable;
+	struct watch watch;	/* Repository changes to refresh on. */
 
 	/* Private data */
 	void *private;
@@ -260,6 +280,9 @@ find_line_by_type(struct view *view, struct line *line, enum line_type type, int
 #define find_next_line_by_type(view, line, type) \
 	find_line_by_type(view, line, type, 1)
 
+struct line *
+find_line_by_id(struct view *view, const char *prefix, const char *(*get_id)(struct line *line));
+
 #define is_initial_view(view) (!(view)->prev && !(view)->argv)
 #define failed_to_load_initial_view(view) (!(view)->prev && !(view)->lines)
 
@@ -286,12 +309,14 @@ void reset_view(struct view *view);
 bool begin_update(struct view *view, const char *dir, const char **argv, enum open_flags flags);
 void end_update(struct view *view, bool force);
 bool update_view(struct view *view);
+bool complete_update(struct view *view);
 void update_view_title(struct view *view);
 
 /*
  * Line utilities.
  */
 
+bool reserve_view_lines(struct view *view, size_t lines);
 struct line *add_line_at(struct view *view, unsigned long pos, const void *data, enum line_type type, size_t data_size, bool custom);
 struct line *add_line(struct view *view, const void *data, enum line_type type, size_t data_size, bool custom);
 struct line *add_line_alloc_(struct view *view, void **ptr, enum line_type type, size_t data_size, bool custom);
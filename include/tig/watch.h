@@ -0,0 +1,55 @@
+/* Copyright (c) 2006-2014 Jonas Fonseca <jonas.fonseca@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#ifndef TIG_WATCH_H
+#define TIG_WATCH_H
+
+#include "tig/tig.h"
+
+/*
+ * Working tree change tracking.
+ */
+
+#define WATCH_MAX_PATHS	1024	/* Changed paths to track before giving up. */
+
+bool watch_worktree(const char *dir);
+const char **watch_worktree_changes(void);
+void watch_worktree_reset(void);
+void watch_worktree_stop(void);
+
+/*
+ * Repository change tracking.
+ */
+
+enum watch_trigger {
+	WATCH_NONE	= 0,
+	WATCH_HEAD	= 1 << 0,	/* HEAD or the current branch. */
+	WATCH_INDEX	= 1 << 1,
+	WATCH_REFS	= 1 << 2,
+};
+
+#define WATCH_TRIGGERS	3
+
+struct watch {
+	struct watch *next;
+	enum watch_trigger triggers;	/* Changes to watch for. */
+	enum watch_trigger changed;	/* Changes since last loaded. */
+};
+
+void watch_register(struct watch *watch, enum watch_trigger triggers);
+bool watch_dirty(struct watch *watch);
+bool watch_wait(int *fd, int *timeout);
+bool watch_update(void);
+
+#endif
+/* vim: set ts=8 sw=8 noexpandtab: */
@@ -20,6 +20,7 @@
 #include "tig/view.h"
 #include "tig/draw.h"
 #include "tig/git.h"
+#include "compat/hashtab.h"
 
 /*
  * Blame backend
@@ -39,6 +40,9 @@ struct blame_history_state {
 
 static struct view_history blame_view_history = { sizeof(struct blame_history_state) };
 
+/* Commits referenced by the lines of the blame view. */
+static htab_t blame_commits;
+
 struct blame {
 	struct blame_commit *commit;
 	unsigned long lineno;
@@ -92,7 +96,6 @@ blame_open(struct view *view, enum open_flags flags)
 	struct blame_state *state = view->private;
 	const char *file_argv[] = { repo.cdup, view->env->file , NULL };
 	char path[SIZEOF_STR];
-	size_t i;
 
 	if (is_initial_view(view)) {
 		/* Finish validating and setting up blame options */
@@ -132,24 +135,6 @@ blame_open(struct view *view, enum open_flags flags)
 			return FALSE;
 	}
 
-	/* First pass: remove multiple references to the same commit. */
-	for (i = 0; i < view->lines; i++) {
-		struct blame *blame = view->line[i].data;
-
-		if (blame->commit && blame->commit->id[0])
-			blame->commit->id[0] = 0;
-		else
-			blame->commit = NULL;
-	}
-
-	/* Second pass: free existing references. */
-	for (i = 0; i < view->lines; i++) {
-		struct blame *blame = view->line[i].data;
-
-		if (blame->commit)
-			free(blame->commit);
-	}
-
 	if (!(flags & OPEN_RELOAD))
 		reset_view_history(&blame_view_history);
 	string_copy_rev(state->history_state.id, view->env->ref);
@@ -162,28 +147,48 @@ blame_open(struct view *view, enum open_flags flags)
 	return TRUE;
 }
 
-static struct blame_commit *
-get_blame_commit(struct view *view, const char *id)
+static hashval_t
+blame_commit_hash(const void *entry)
 {
-	size_t i;
-
-	for (i = 0; i < view->lines; i++) {
-		struct blame *blame = view->line[i].data;
+	return htab_hash_string(((const struct blame_commit *) entry)->id);
+}
 
-		if (!blame->commit)
-			continue;
+static int
+blame_commit_eq(const void *entry, const void *id)
+{
+	return !strcmp(((const struct blame_commit *) entry)->id, id);
+}
 
-		if (!strncmp(blame->commit->id, id, SIZEOF_REV - 1))
-			return blame->commit;
+static struct blame_commit *
+get_blame_commit(struct view *view, const char *text)
+{
+	struct blame_commit *commit;
+	char id[SIZEOF_REV];
+	hashval_t hash;
+	void **slot;
+
+	if (!blame_commits) {
+		blame_commits = htab_create_alloc(256, blame_commit_hash, blame_commit_eq, free, calloc, free);
+		if (!blame_commits)
+			return NULL;
 	}
 
-	{
-		struct blame_commit *commit = calloc(1, sizeof(*commit));
-
-		if (commit)
-			string_ncopy(commit->id, id, SIZEOF_REV);
+	string_ncopy(id, text, SIZEOF_REV);
+	hash = htab_hash_string(id);
+	commit = htab_find_with_hash(blame_commits, id, hash);
+	if (commit)
 		return commit;
+
+	commit = calloc(1, sizeof(*commit));
+	slot = commit ? htab_find_slot_with_hash(blame_commits, id, hash, INSERT) : NULL;
+	if (!slot) {
+		free(commit);
+		return NULL;
 	}
+
+	string_copy_rev(commit->id, id);
+	*slot = commit;
+	return commit;
 }
 
 static struct blame_commit *
@@ -284,6 +289,15 @@ blame_read(struct view *view, char *line)
 	return TRUE;
 }
 
+static void
+blame_done(struct view *view)
+{
+	/* The lines are about to be freed, and with them the last
+	 * references to the commits. */
+	if (blame_commits)
+		htab_empty(blame_commits);
+}
+
 static bool
 blame_draw(struct view *view, struct line *line, unsigned int lineno)
 {
@@ -533,6 +547,7 @@ struct view_ops blame_ops = {
 	blame_request,
 	blame_grep,
 	blame_select,
+	blame_done,
 };
 
 /* vim: set ts=8 sw=8 noexpandtab: */
@@ -106,7 +106,7 @@ struct view_ops blob_ops = {
 	"line",
 	{ "blob" },
 	argv_env.blob,
-	VIEW_NO_FLAGS,
+	VIEW_KEEP_TEXT,
 	sizeof(struct blob_state),
 	blob_open,
 	blob_read,
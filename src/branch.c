@@ -28,6 +28,7 @@ struct branch {
 	struct time time;		/* Date of the last activity. */
 	char title[128];		/* First line of the commit message. */
 	const struct ref *ref;		/* Name and commit ID information. */
+	char id[SIZEOF_REV];		/* Commit ID of the ref when loaded. */
 };
 
 static const struct ref branch_all;
@@ -89,13 +90,21 @@ branch_draw(struct view *view, struct line *line, unsigned int lineno)
 	if (draw_field(view, type, branch_name, state->max_ref_length, ALIGN_LEFT, FALSE))
 		return TRUE;
 
-	if (draw_id(view, branch->ref->id))
+	if (draw_id(view, branch->id))
 		return TRUE;
 
 	draw_text(view, LINE_DEFAULT, branch->title);
 	return TRUE;
 }
 
+static const char *
+branch_get_id(struct line *line)
+{
+	struct branch *branch = line->data;
+
+	return branch->id;
+}
+
 static enum request
 branch_request(struct view *view, enum request request, struct line *line)
 {
@@ -125,17 +134,16 @@ branch_request(struct view *view, enum request request, struct line *line)
 	}
 	case REQ_JUMP_COMMIT:
 	{
-		int lineno;
-
-		for (lineno = 0; lineno < view->lines; lineno++) {
-			struct branch *branch = view->line[lineno].data;
+		struct line *branch_line = find_line_by_id(view, view->env->search, branch_get_id);
 
-			if (!strncasecmp(branch->ref->id, view->env->search, strlen(view->env->search))) {
-				select_view_line(view, lineno);
-				report_clear();
-				return REQ_NONE;
-			}
+		if (!branch_line) {
+			report("Unable to find commit '%s'", view->env->search);
+			return REQ_NONE;
 		}
+
+		select_view_line(view, branch_line - view->line);
+		report_clear();
+		return REQ_NONE;
 	}
 	default:
 		return request;
@@ -170,7 +178,7 @@ branch_read(struct view *view, char *line)
 	for (i = 0; i < view->lines; i++) {
 		struct branch *branch = view->line[i].data;
 
-		if (strcmp(branch->ref->id, state->id))
+		if (strcmp(branch->id, state->id))
 			continue;
 
 		if (author) {
@@ -207,6 +215,9 @@ branch_open_visitor(void *data, const struct ref *ref)
 		state->max_ref_length = ref_length;
 
 	branch->ref = ref;
+	/* Refs are updated in place when reloaded by other views, so keep
+	 * the ID shown, searched and indexed by the view. */
+	string_copy_rev(branch->id, ref->id);
 	return TRUE;
 }
 
@@ -219,6 +230,7 @@ branch_open(struct view *view, enum open_flags flags)
 			"--all", "--simplify-by-decoration", NULL
 	};
 
+	watch_register(&view->watch, WATCH_HEAD | WATCH_REFS);
 	if (!begin_update(view, NULL, branch_log, OPEN_RELOAD)) {
 		report("Failed to load branch data");
 		return FALSE;
@@ -252,9 +264,9 @@ branch_select(struct view *view, struct line *line)
 		string_copy(view->ref, BRANCH_ALL_NAME);
 		return;
 	}
-	string_copy_rev(view->ref, branch->ref->id);
-	string_copy_rev(view->env->commit, branch->ref->id);
-	string_copy_rev(view->env->head, branch->ref->id);
+	string_copy_rev(view->ref, branch->id);
+	string_copy_rev(view->env->commit, branch->id);
+	string_copy_rev(view->env->head, branch->id);
 	string_copy_rev(view->env->branch, branch->ref->name);
 }
 
@@ -0,0 +1,108 @@
+/* Copyright (c) 2006-2014 Jonas Fonseca <jonas.fonseca@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "tig/tig.h"
+#include "tig/repo.h"
+#include "tig/cache.h"
+
+static bool
+cache_path(char path[SIZEOF_STR], const char *name)
+{
+	return *repo.git_dir &&
+	       string_format_size(path, SIZEOF_STR, "%s/tig-%s.cache", repo.git_dir, name);
+}
+
+bool
+cache_map(struct cache_file *file, const char *name)
+{
+	char path[SIZEOF_STR];
+	struct stat st;
+	void *map;
+	int fd;
+
+	memset(file, 0, sizeof(*file));
+
+	if (!cache_path(path, name) || (fd = open(path, O_RDONLY)) == -1)
+		return FALSE;
+
+	if (fstat(fd, &st) || st.st_size == 0) {
+		close(fd);
+		return FALSE;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return FALSE;
+
+	file->data = map;
+	file->size = st.st_size;
+	return TRUE;
+}
+
+void
+cache_unmap(struct cache_file *file)
+{
+	if (file->data)
+		munmap((void *) file->data, file->size);
+	memset(file, 0, sizeof(*file));
+}
+
+/* Cache files are written to a temporary file, which replaces the
+ * old cache file once it is complete. Concurrent writers will at
+ * worst overwrite each other's cache file. */
+bool
+cache_write_begin(struct cache_writer *writer, const char *name)
+{
+	int fd;
+
+	memset(writer, 0, sizeof(*writer));
+
+	if (!cache_path(writer->path, name) ||
+	    !string_format(writer->tmp, "%s.XXXXXX", writer->path) ||
+	    (fd = mkstemp(writer->tmp)) == -1)
+		return FALSE;
+
+	writer->file = fdopen(fd, "w");
+	if (!writer->file) {
+		close(fd);
+		unlink(writer->tmp);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+bool
+cache_write(struct cache_writer *writer, const void *data, size_t size)
+{
+	return !size || fwrite(data, size, 1, writer->file) == 1;
+}
+
+bool
+cache_write_end(struct cache_writer *writer, bool commit)
+{
+	bool ok = !ferror(writer->file);
+
+	if (fclose(writer->file))
+		ok = FALSE;
+	writer->file = NULL;
+
+	if (commit && ok && !rename(writer->tmp, writer->path))
+		return TRUE;
+
+	unlink(writer->tmp);
+	return FALSE;
+}
+
+/* vim: set ts=8 sw=8 noexpandtab: */
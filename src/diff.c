@@ -476,7 +476,7 @@ struct view_ops diff_ops = {
 	"line",
 	{ "diff" },
 	argv_env.commit,
-	VIEW_DIFF_LIKE | VIEW_ADD_DESCRIBE_REF | VIEW_ADD_PAGER_REFS | VIEW_FILE_FILTER | VIEW_REFRESH,
+	VIEW_DIFF_LIKE | VIEW_ADD_DESCRIBE_REF | VIEW_ADD_PAGER_REFS | VIEW_FILE_FILTER | VIEW_REFRESH | VIEW_KEEP_TEXT,
 	sizeof(struct diff_state),
 	diff_open,
 	diff_read,
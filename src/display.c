@@ -19,6 +19,7 @@
 #include "tig/view.h"
 #include "tig/draw.h"
 #include "tig/display.h"
+#include "tig/status.h"
 
 struct view *display[2];
 unsigned int current_view;
@@ -375,6 +376,51 @@ init_display(void)
 	}
 }
 
+DEFINE_ALLOCATOR(realloc_pollfds, struct pollfd, 8)
+
+/* Sleep until either the terminal or one of the loading views has
+ * something to read, or more files can be updated. The timeout allows
+ * views without any lines to update the title with the time spent
+ * loading. */
+static void
+wait_for_input(int watch_fd, int update_fd, int timeout)
+{
+	static struct pollfd *fds;
+	size_t nfds = 0;
+	struct view *view;
+	int i;
+
+	foreach_view (view, i) {
+		if (!view->pipe || view->pipe->pipe == -1)
+			continue;
+		if (!realloc_pollfds(&fds, nfds, 1))
+			return;
+		fds[nfds].fd = view->pipe->pipe;
+		fds[nfds++].events = POLLIN;
+	}
+
+	if (watch_fd != -1) {
+		if (!realloc_pollfds(&fds, nfds, 1))
+			return;
+		fds[nfds].fd = watch_fd;
+		fds[nfds++].events = POLLIN;
+	}
+
+	if (update_fd != -1) {
+		if (!realloc_pollfds(&fds, nfds, 1))
+			return;
+		fds[nfds].fd = update_fd;
+		fds[nfds++].events = POLLOUT;
+	}
+
+	if (!realloc_pollfds(&fds, nfds, 1))
+		return;
+	fds[nfds].fd = fileno(opt_tty);
+	fds[nfds++].events = POLLIN;
+
+	poll(fds, nfds, timeout);
+}
+
 int
 get_input(int prompt_position, struct key_input *input, bool modifiers)
 {
@@ -388,6 +434,14 @@ get_input(int prompt_position, struct key_input *input, bool modifiers)
 
 	while (TRUE) {
 		bool loading = FALSE;
+		bool watching = FALSE;
+		bool updating = FALSE;
+		int watch_fd = -1, update_fd = -1, timeout = -1;
+
+		/* Views reloaded after updating files have to start loading
+		 * before checking which views are loading. */
+		if (!prompt_position)
+			status_update_continue();
 
 		foreach_view (view, i) {
 			update_view(view);
@@ -411,14 +465,35 @@ get_input(int prompt_position, struct key_input *input, bool modifiers)
 		}
 		setsyx(cursor_y, cursor_x);
 
+		/* Repository changes and file updates are only handled
+		 * outside of prompts. */
+		if (!prompt_position) {
+			updating = status_update_wait(&update_fd);
+			watching = watch_wait(&watch_fd, &timeout);
+		}
+		if (loading && (timeout == -1 || timeout > 500))
+			timeout = 500;
+
 		/* Refresh, accept single keystroke of input */
 		doupdate();
-		nodelay(status_win, loading);
+		nodelay(status_win, loading || watching || updating);
 		key = wgetch(status_win);
 
 		/* wgetch() with nodelay() enabled returns ERR when
 		 * there's no input. */
 		if (key == ERR) {
+			if (loading || watching || updating)
+				wait_for_input(watch_fd, update_fd, timeout);
+			if (watching) {
+				watch_update();
+				/* Let views finish loading and files finish
+				 * updating before refreshing. */
+				foreach_displayed_view (view, i) {
+					if (watch_dirty(&view->watch) && view_can_refresh(view) &&
+					    !view->pipe && !updating)
+						return KEY_REPO_CHANGED;
+				}
+			}
 
 		} else if (key == KEY_ESC && modifiers) {
 			input->modifiers.escape = 1;
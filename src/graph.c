@@ -18,8 +18,9 @@
 DEFINE_ALLOCATOR(realloc_graph_columns, struct graph_column, 32)
 DEFINE_ALLOCATOR(realloc_graph_symbols, struct graph_symbol, 1)
 
+/* IDs are interned, so they can be compared and hashed by pointer. */
 struct id_color {
-	char *id;
+	const char *id;
 	size_t color;
 };
 
@@ -28,9 +29,10 @@ id_color_new(const char *id, size_t color)
 {
 	struct id_color *node = malloc(sizeof(struct id_color));
 
-	node->id = (char *) malloc(strlen(id) + 1);
-	strcpy(node->id, id);
-	node->color = color;
+	if (node) {
+		node->id = id;
+		node->color = color;
+	}
 
 	return node;
 }
@@ -38,14 +40,13 @@ id_color_new(const char *id, size_t color)
 static void
 id_color_delete(struct id_color *node)
 {
-	free(node->id);
 	free(node);
 }
 
 static int
 id_color_eq(const void *entry, const void *element)
 {
-	return strcmp(((const struct id_color *) entry)->id, ((const struct id_color *) element)->id) == 0;
+	return ((const struct id_color *) entry)->id == ((const struct id_color *) element)->id;
 }
 
 static void
@@ -57,14 +58,14 @@ key_del(void *key)
 static hashval_t
 id_color_hash(const void *node)
 {
-	return htab_hash_string(((const struct id_color*) node)->id);
+	return htab_hash_pointer(((const struct id_color*) node)->id);
 }
 
 static void
 colors_add_id(struct colors *colors, const char *id, const size_t color)
 {
 	struct id_color *node = id_color_new(id, color);
-	void **slot = htab_find_slot(colors->id_map, node, INSERT);
+	void **slot = node ? htab_find_slot(colors->id_map, node, INSERT) : NULL;
 
 	if (slot != NULL && *slot == NULL) {
 		*slot = node;
@@ -77,24 +78,20 @@ colors_add_id(struct colors *colors, const char *id, const size_t color)
 static void
 colors_remove_id(struct colors *colors, const char *id)
 {
-	struct id_color *node = id_color_new(id, 0);
-	void **slot = htab_find_slot(colors->id_map, node, NO_INSERT);
+	struct id_color key = { id };
+	void **slot = htab_find_slot(colors->id_map, &key, NO_INSERT);
 
 	if (slot != NULL && *slot != NULL) {
 		colors->count[((struct id_color *) *slot)->color]--;
 		htab_clear_slot(colors->id_map, slot);
 	}
-
-	id_color_delete(node);
 }
 
 static size_t
 colors_get_color(struct colors *colors, const char *id)
 {
-	struct id_color *key = id_color_new(id, 0);
-	struct id_color *node = (struct id_color *) htab_find(colors->id_map, key);
-
-	id_color_delete(key);
+	struct id_color key = { id };
+	struct id_color *node = (struct id_color *) htab_find(colors->id_map, &key);
 
 	if (node == NULL) {
 		return (size_t) -1; // Max value of size_t. ID not found.
@@ -129,7 +126,7 @@ colors_init(struct colors *colors)
 }
 
 static size_t
-get_color(struct graph *graph, char *new_id)
+get_color(struct graph *graph, const char *new_id)
 {
 	size_t color;
 
@@ -153,10 +150,34 @@ done_graph(struct graph *graph)
 	free(graph->row.columns);
 	free(graph->next_row.columns);
 	free(graph->parents.columns);
+	free(graph->symbols);
+	if (graph->colors.id_map)
+		htab_delete(graph->colors.id_map);
+	string_pool_free(&graph->ids);
 	memset(graph, 0, sizeof(*graph));
 }
 
-#define graph_column_has_commit(col) ((col)->id[0])
+/* Replaces an ID, which ends at the first space, by its shared copy
+ * or NULL if it is empty. */
+static bool
+graph_intern_id(struct graph *graph, const char **id)
+{
+	size_t idlen;
+
+	for (idlen = 0; idlen < SIZEOF_REV - 1 && (*id)[idlen]; idlen++)
+		if (isspace((unsigned char) (*id)[idlen]))
+			break;
+
+	if (!idlen) {
+		*id = NULL;
+		return TRUE;
+	}
+
+	*id = string_pool_intern(&graph->ids, *id, idlen);
+	return *id != NULL;
+}
+
+#define graph_column_has_commit(col) ((col)->id != NULL)
 
 static size_t
 graph_find_column_by_id(struct graph_row *row, const char *id)
@@ -167,7 +188,7 @@ graph_find_column_by_id(struct graph_row *row, const char *id)
 	for (i = 0; i < row->size; i++) {
 		if (!graph_column_has_commit(&row->columns[i]) && free_column == row->size)
 			free_column = i;
-		else if (!strcmp(row->columns[i].id, id))
+		else if (row->columns[i].id == id)
 			return i;
 	}
 
@@ -192,7 +213,10 @@ graph_insert_column(struct graph *graph, struct graph_row *row, size_t pos, cons
 {
 	struct graph_column *column;
 
-	if (!realloc_graph_columns(&row->columns, row->size, 1))
+	/* Keep a spare column after the last one, which is read when
+	 * removing collapsed columns. */
+	if (!graph_intern_id(graph, &id) ||
+	    !realloc_graph_columns(&row->columns, row->size, 2))
 		return NULL;
 
 	column = &row->columns[pos];
@@ -202,7 +226,7 @@ graph_insert_column(struct graph *graph, struct graph_row *row, size_t pos, cons
 
 	row->size++;
 	memset(column, 0, sizeof(*column));
-	string_copy_rev(column->id, id);
+	column->id = id;
 	column->symbol.boundary = !!graph->is_boundary;
 
 	return column;
@@ -256,13 +280,95 @@ graph_collapse(struct graph *graph)
 	return TRUE;
 }
 
+/*
+ * Canvas interning
+ *
+ * Most rows of a graph have the same symbols as many other rows, e.g.
+ * a commit on the first of a few vertical lines. Each distinct row of
+ * symbols is stored once in the graph's arena and shared by all the
+ * canvases with that row. The table of rows is allocated in the arena
+ * as well, so it can be kept by the owner of the arena and be used by
+ * later graphs rendering more rows.
+ */
+
+static void *
+graph_canvases_alloc(void *arena, size_t count, size_t size)
+{
+	void *mem = arena_alloc(arena, count * size);
+
+	if (mem)
+		memset(mem, 0, count * size);
+	return mem;
+}
+
 static void
-graph_canvas_append_symbol(struct graph *graph, struct graph_symbol *symbol)
+graph_canvases_free(void *arena, void *mem)
+{
+	/* Freed along with the arena. */
+}
+
+static hashval_t
+graph_canvas_hash(const void *entry)
+{
+	const struct graph_canvas *canvas = entry;
+
+	return iterative_hash(canvas->symbols, canvas->size * sizeof(*canvas->symbols), canvas->size);
+}
+
+static int
+graph_canvas_eq(const void *entry, const void *key)
+{
+	const struct graph_canvas *canvas1 = entry;
+	const struct graph_canvas *canvas2 = key;
+
+	return canvas1->size == canvas2->size &&
+	       !memcmp(canvas1->symbols, canvas2->symbols, canvas1->size * sizeof(*canvas1->symbols));
+}
+
+static bool
+graph_set_canvas(struct graph *graph, struct graph_canvas *canvas,
+		 const struct graph_symbol *symbols, size_t size)
 {
-	struct graph_canvas *canvas = graph->canvas;
+	struct graph_canvas key = { size, symbols };
+	hashval_t hash = graph_canvas_hash(&key);
+	struct graph_canvas *entry;
+	struct graph_symbol *copy;
+	void **slot;
+
+	if (!graph->canvases) {
+		graph->canvases = htab_create_alloc_ex(1024, graph_canvas_hash, graph_canvas_eq, NULL,
+						       graph->arena, graph_canvases_alloc, graph_canvases_free);
+		if (!graph->canvases)
+			return FALSE;
+	}
+
+	slot = htab_find_slot_with_hash(graph->canvases, &key, hash, INSERT);
+	if (!slot)
+		return FALSE;
+
+	if (!*slot) {
+		entry = arena_alloc(graph->arena, sizeof(*entry) + size * sizeof(*symbols));
+		if (!entry) {
+			htab_clear_slot(graph->canvases, slot);
+			return FALSE;
+		}
+
+		copy = (struct graph_symbol *) (entry + 1);
+		memcpy(copy, symbols, size * sizeof(*symbols));
+		entry->size = size;
+		entry->symbols = copy;
+		*slot = entry;
+	}
 
-	if (realloc_graph_symbols(&canvas->symbols, canvas->size, 1))
-		canvas->symbols[canvas->size++] = *symbol;
+	*canvas = *(struct graph_canvas *) *slot;
+	return TRUE;
+}
+
+static void
+graph_canvas_append_symbol(struct graph *graph, struct graph_symbol *symbol)
+{
+	if (realloc_graph_symbols(&graph->symbols, graph->symbols_size, 1))
+		graph->symbols[graph->symbols_size++] = *symbol;
 }
 
 static void
@@ -271,8 +377,8 @@ graph_row_clear_commit(struct graph_row *row, const char *id)
 	int i;
 
 	for (i = 0; i < row->size; i++) {
-		if (strcmp(row->columns[i].id, id) == 0) {
-			row->columns[i].id[0] = 0;
+		if (row->columns[i].id == id) {
+			row->columns[i].id = NULL;
 		}
 	}
 }
@@ -292,7 +398,7 @@ graph_insert_parents(struct graph *graph)
 		if (graph_column_has_commit(new)) {
 			size_t match = graph_find_free_column(next_row);
 
-			if (match == next_row->size && next_row->columns[next_row->size - 1].id) {
+			if (match == next_row->size) {
 				graph_insert_column(graph, next_row, next_row->size, new->id);
 				graph_insert_column(graph, row, row->size, "");
 				graph_insert_column(graph, prev_row, prev_row->size, "");
@@ -312,7 +418,7 @@ commit_is_in_row(const char *id, struct graph_row *row)
 		if (!graph_column_has_commit(&row->columns[i]))
 			continue;
 
-		if (strcmp(id, row->columns[i].id) == 0)
+		if (id == row->columns[i].id)
 			return true;
 	}
 	return false;
@@ -331,16 +437,16 @@ graph_remove_collapsed_columns(struct graph *graph)
 		if (i == graph->position + 1)
 			continue;
 
-		if (strcmp(row->columns[i].id, graph->id) == 0)
+		if (row->columns[i].id == graph->id)
 			continue;
 
-		if (strcmp(row->columns[i].id, row->columns[i - 1].id) != 0)
+		if (row->columns[i].id != row->columns[i - 1].id)
 			continue;
 
 		if (commit_is_in_row(row->columns[i].id, &graph->parents) && !graph_column_has_commit(&graph->prev_row.columns[i]))
 			continue;
 
-		if (strcmp(row->columns[i - 1].id, graph->prev_row.columns[i - 1].id) != 0 || graph->prev_row.columns[i - 1].symbol.shift_left)
+		if (row->columns[i - 1].id != graph->prev_row.columns[i - 1].id || graph->prev_row.columns[i - 1].symbol.shift_left)
 			row->columns[i] = row->columns[i + 1];
 	}
 }
@@ -404,7 +510,7 @@ graph_commit_next_row(struct graph *graph)
 static bool
 continued_down(struct graph_row *row, struct graph_row *next_row, int pos)
 {
-	if (strcmp(row->columns[pos].id, next_row->columns[pos].id) != 0)
+	if (row->columns[pos].id != next_row->columns[pos].id)
 		return false;
 
 	if (row->columns[pos].symbol.shift_left)
@@ -418,14 +524,14 @@ shift_left(struct graph_row *row, struct graph_row *prev_row, int pos)
 {
 	int i;
 
-	if (!graph_column_has_commit(&row->columns[pos]))
+	if (pos >= row->size || !graph_column_has_commit(&row->columns[pos]))
 		return false;
 
 	for (i = pos - 1; i >= 0; i--) {
 		if (!graph_column_has_commit(&row->columns[i]))
 			continue;
 
-		if (strcmp(row->columns[i].id, row->columns[pos].id) != 0)
+		if (row->columns[i].id != row->columns[pos].id)
 			continue;
 
 		if (!continued_down(prev_row, row, i))
@@ -446,7 +552,7 @@ new_column(struct graph_row *row, struct graph_row *prev_row, int pos)
 		return true;
 
 	for (i = pos; i < row->size; i++) {
-		if (strcmp(row->columns[pos].id, prev_row->columns[i].id) == 0)
+		if (row->columns[pos].id == prev_row->columns[i].id)
 			return false;
 	}
 
@@ -464,7 +570,7 @@ continued_right(struct graph_row *row, int pos, int commit_pos)
 		end = row->size;
 
 	for (i = pos + 1; i < end; i++) {
-		if (strcmp(row->columns[pos].id, row->columns[i].id) == 0)
+		if (row->columns[pos].id == row->columns[i].id)
 			return true;
 	}
 
@@ -485,7 +591,7 @@ continued_left(struct graph_row *row, int pos, int commit_pos)
 		if (!graph_column_has_commit(&row->columns[i]))
 			continue;
 
-		if (strcmp(row->columns[pos].id, row->columns[i].id) == 0)
+		if (row->columns[pos].id == row->columns[i].id)
 			return true;
 	}
 
@@ -501,7 +607,7 @@ parent_down(struct graph_row *parents, struct graph_row *next_row, int pos)
 		if (!graph_column_has_commit(&parents->columns[parent]))
 			continue;
 
-		if (strcmp(parents->columns[parent].id, next_row->columns[pos].id) == 0)
+		if (parents->columns[parent].id == next_row->columns[pos].id)
 			return true;
 	}
 
@@ -518,10 +624,10 @@ parent_right(struct graph_row *parents, struct graph_row *row, struct graph_row
 			continue;
 
 		for (i = pos + 1; i < next_row->size; i++) {
-			if (strcmp(parents->columns[parent].id, next_row->columns[i].id) != 0)
+			if (parents->columns[parent].id != next_row->columns[i].id)
 				continue;
 
-			if (strcmp(parents->columns[parent].id, row->columns[i].id) != 0)
+			if (parents->columns[parent].id != row->columns[i].id)
 				return true;
 		}
 	}
@@ -543,7 +649,7 @@ flanked(struct graph_row *row, int pos, int commit_pos, const char *commit_id)
 	}
 
 	for (i = start; i < end; i++) {
-		if (strcmp(row->columns[i].id, commit_id) == 0)
+		if (row->columns[i].id == commit_id)
 			return true;
 	}
 
@@ -556,7 +662,7 @@ below_commit(int pos, struct graph *graph)
 	if (!pos == graph->prev_position)
 		return false;
 
-	if (!strcmp(graph->row.columns[pos].id, graph->prev_row.columns[pos].id) == 0)
+	if (graph->row.columns[pos].id != graph->prev_row.columns[pos].id)
 		return false;
 
 	return true;
@@ -571,10 +677,12 @@ graph_generate_symbols(struct graph *graph)
 	struct graph_row *parents = &graph->parents;
 	int pos;
 
+	graph->symbols_size = 0;
+
 	for (pos = 0; pos < row->size; pos++) {
 		struct graph_column *column = &row->columns[pos];
 		struct graph_symbol *symbol = &column->symbol;
-		char *id = next_row->columns[pos].id;
+		const char *id = next_row->columns[pos].id;
 
 		symbol->commit            = (pos == graph->position);
 		symbol->boundary          = (pos == graph->position && next_row->columns[pos].symbol.boundary);
@@ -593,7 +701,7 @@ graph_generate_symbols(struct graph *graph)
 		symbol->below_commit      = below_commit(pos, graph);
 		symbol->flanked           = flanked(row, pos, graph->position, graph->id);
 		symbol->next_right        = continued_right(next_row, pos, 0);
-		symbol->matches_commit    = (strcmp(column->id, graph->id) == 0);
+		symbol->matches_commit    = (column->id == graph->id);
 
 		symbol->shift_left        = shift_left(row, prev_row, pos);
 		symbol->continue_shift    = shift_left(row, prev_row, pos + 1);
@@ -610,6 +718,8 @@ graph_generate_symbols(struct graph *graph)
 		graph_canvas_append_symbol(graph, symbol);
 	}
 
+	if (graph->canvas)
+		graph_set_canvas(graph, graph->canvas, graph->symbols, graph->symbols_size);
 	colors_remove_id(&graph->colors, graph->id);
 }
 
@@ -631,12 +741,189 @@ graph_render_parents(struct graph *graph)
 	return TRUE;
 }
 
+/*
+ * Lane state
+ *
+ * The state left behind by the rendered commits is all that is needed
+ * to render the following commits, so a saved state can be restored to
+ * continue rendering from the commit after it.
+ */
+
+struct graph_state_column {
+	unsigned char id[SIZEOF_ID];
+	uint32_t value;
+};
+
+#define GRAPH_STATE_HEADER	(3 + GRAPH_COLORS)
+#define GRAPH_STATE_HAS_ID	(1U << 31)
+
+static bool
+graph_state_column(struct graph_state_column *column, const char *id, uint32_t value)
+{
+	memset(column, 0, sizeof(*column));
+	column->value = value;
+	if (!id)
+		return TRUE;
+	column->value |= GRAPH_STATE_HAS_ID;
+	return string_rev_to_id(column->id, id);
+}
+
+static int
+graph_state_add_color(void **slot, void *data)
+{
+	struct graph_state_column **column = data;
+	struct id_color *node = *slot;
+
+	if (!graph_state_column(*column, node->id, node->color))
+		return 0;
+	(*column)++;
+	return 1;
+}
+
+static int
+graph_state_compare_colors(const void *column1, const void *column2)
+{
+	return memcmp(column1, column2, sizeof(struct graph_state_column));
+}
+
+static void
+graph_state_column_id(char id[SIZEOF_REV], const struct graph_state_column *column)
+{
+	if (column->value & GRAPH_STATE_HAS_ID)
+		string_id_to_rev(id, column->id);
+	else
+		id[0] = 0;
+}
+
+static bool
+graph_state_insert_column(struct graph *graph, struct graph_row *row,
+			  const struct graph_state_column *state)
+{
+	uint32_t value = state->value & ~GRAPH_STATE_HAS_ID;
+	struct graph_column *column;
+	char id[SIZEOF_REV];
+
+	graph_state_column_id(id, state);
+	column = graph_insert_column(graph, row, row->size, id);
+	if (!column)
+		return FALSE;
+	memcpy(&column->symbol, &value, sizeof(column->symbol));
+	return TRUE;
+}
+
+size_t
+graph_state_size(struct graph *graph)
+{
+	size_t colors = graph->colors.id_map ? htab_elements(graph->colors.id_map) : 0;
+
+	return GRAPH_STATE_HEADER * sizeof(uint32_t)
+	     + (graph->row.size * 2 + colors) * sizeof(struct graph_state_column);
+}
+
+/* Fails if the state contains IDs which are not SHA1 IDs. */
+bool
+graph_get_state(struct graph *graph, void *state)
+{
+	uint32_t *header = state;
+	struct graph_state_column *column = (void *) (header + GRAPH_STATE_HEADER);
+	struct graph_state_column *colors;
+	uint32_t value;
+	size_t i;
+
+	header[0] = graph->row.size;
+	header[1] = graph->prev_position;
+	for (i = 0; i < GRAPH_COLORS; i++)
+		header[2 + i] = graph->colors.count[i];
+	header[2 + GRAPH_COLORS] = graph->colors.id_map ? htab_elements(graph->colors.id_map) : 0;
+
+	for (i = 0; i < graph->row.size; i++) {
+		memcpy(&value, &graph->prev_row.columns[i].symbol, sizeof(value));
+		if (!graph_state_column(column++, graph->prev_row.columns[i].id, value))
+			return FALSE;
+		memcpy(&value, &graph->row.columns[i].symbol, sizeof(value));
+		if (!graph_state_column(column++, graph->row.columns[i].id, value))
+			return FALSE;
+	}
+
+	/* Sort the colors, so equal states can be compared byte by byte
+	 * whatever the order of the hash table. */
+	colors = column;
+	if (graph->colors.id_map)
+		htab_traverse_noresize(graph->colors.id_map, graph_state_add_color, &column);
+	if (column - colors != header[2 + GRAPH_COLORS])
+		return FALSE;
+	qsort(colors, column - colors, sizeof(*colors), graph_state_compare_colors);
+	return TRUE;
+}
+
+/* Checks a state read from a file before it is restored. */
+bool
+graph_check_state(const void *state, size_t size)
+{
+	const uint32_t *header = state;
+	const struct graph_state_column *column = (const void *) (header + GRAPH_STATE_HEADER);
+	size_t i;
+
+	if (size < GRAPH_STATE_HEADER * sizeof(uint32_t) ||
+	    size != GRAPH_STATE_HEADER * sizeof(uint32_t) +
+		    ((size_t) header[0] * 2 + header[2 + GRAPH_COLORS]) * sizeof(*column))
+		return FALSE;
+
+	for (i = header[0] * 2; i < header[0] * 2 + header[2 + GRAPH_COLORS]; i++)
+		if ((column[i].value & ~GRAPH_STATE_HAS_ID) >= GRAPH_COLORS)
+			return FALSE;
+
+	return TRUE;
+}
+
+/* Restores a state saved by graph_get_state() in an empty graph. */
+bool
+graph_set_state(struct graph *graph, const void *state)
+{
+	const uint32_t *header = state;
+	const struct graph_state_column *column = (const void *) (header + GRAPH_STATE_HEADER);
+	char id[SIZEOF_REV];
+	size_t i;
+
+	for (i = 0; i < header[0]; i++) {
+		if (!graph_state_insert_column(graph, &graph->prev_row, column++) ||
+		    !graph_state_insert_column(graph, &graph->row, column++) ||
+		    !graph_insert_column(graph, &graph->next_row, i, ""))
+			return FALSE;
+		graph->next_row.columns[i] = graph->row.columns[i];
+	}
+
+	graph->prev_position = header[1];
+
+	colors_init(&graph->colors);
+	if (!graph->colors.id_map)
+		return FALSE;
+
+	for (i = 0; i < header[2 + GRAPH_COLORS]; i++, column++) {
+		const char *color_id = id;
+
+		graph_state_column_id(id, column);
+		if (!graph_intern_id(graph, &color_id))
+			return FALSE;
+		colors_add_id(&graph->colors, color_id, column->value & ~GRAPH_STATE_HAS_ID);
+	}
+
+	for (i = 0; i < GRAPH_COLORS; i++)
+		graph->colors.count[i] = header[2 + i];
+
+	return TRUE;
+}
+
+/* Without a canvas only the lanes are updated, e.g. when passing rows
+ * which have already been rendered. */
 bool
 graph_add_commit(struct graph *graph, struct graph_canvas *canvas,
 		 const char *id, const char *parents, bool is_boundary)
 {
-	graph->position = graph_find_column_by_id(&graph->row, id);
-	string_copy_rev(graph->id, id);
+	graph->id = id;
+	if (!graph_intern_id(graph, &graph->id))
+		return FALSE;
+	graph->position = graph_find_column_by_id(&graph->row, graph->id);
 	graph->canvas = canvas;
 	graph->is_boundary = is_boundary;
 
@@ -655,7 +942,7 @@ graph_add_commit(struct graph *graph, struct graph_canvas *canvas,
 }
 
 const bool
-graph_symbol_forks(struct graph_symbol *symbol)
+graph_symbol_forks(const struct graph_symbol *symbol)
 {
 	if (!symbol->continued_down)
 		return false;
@@ -670,7 +957,7 @@ graph_symbol_forks(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_cross_over(struct graph_symbol *symbol)
+graph_symbol_cross_over(const struct graph_symbol *symbol)
 {
 	if (symbol->empty)
 		return false;
@@ -694,7 +981,7 @@ graph_symbol_cross_over(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_turn_left(struct graph_symbol *symbol)
+graph_symbol_turn_left(const struct graph_symbol *symbol)
 {
 	if (symbol->matches_commit && symbol->continued_right && !symbol->continued_down)
 		return false;
@@ -714,7 +1001,7 @@ graph_symbol_turn_left(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_turn_down_cross_over(struct graph_symbol *symbol)
+graph_symbol_turn_down_cross_over(const struct graph_symbol *symbol)
 {
 	if (!symbol->continued_down)
 		return false;
@@ -732,7 +1019,7 @@ graph_symbol_turn_down_cross_over(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_turn_down(struct graph_symbol *symbol)
+graph_symbol_turn_down(const struct graph_symbol *symbol)
 {
 	if (!symbol->continued_down)
 		return false;
@@ -744,7 +1031,7 @@ graph_symbol_turn_down(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_merge(struct graph_symbol *symbol)
+graph_symbol_merge(const struct graph_symbol *symbol)
 {
 	if (symbol->continued_down)
 		return false;
@@ -759,7 +1046,7 @@ graph_symbol_merge(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_multi_merge(struct graph_symbol *symbol)
+graph_symbol_multi_merge(const struct graph_symbol *symbol)
 {
 	if (!symbol->parent_down)
 		return false;
@@ -771,7 +1058,7 @@ graph_symbol_multi_merge(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_vertical_bar(struct graph_symbol *symbol)
+graph_symbol_vertical_bar(const struct graph_symbol *symbol)
 {
 	if (symbol->empty)
 		return false;
@@ -798,7 +1085,7 @@ graph_symbol_vertical_bar(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_horizontal_bar(struct graph_symbol *symbol)
+graph_symbol_horizontal_bar(const struct graph_symbol *symbol)
 {
 	if (symbol->shift_left)
 		return true;
@@ -819,7 +1106,7 @@ graph_symbol_horizontal_bar(struct graph_symbol *symbol)
 }
 
 const bool
-graph_symbol_multi_branch(struct graph_symbol *symbol)
+graph_symbol_multi_branch(const struct graph_symbol *symbol)
 {
 	if (symbol->continued_down)
 		return false;
@@ -842,7 +1129,7 @@ graph_symbol_multi_branch(struct graph_symbol *symbol)
 }
 
 const char *
-graph_symbol_to_utf8(struct graph_symbol *symbol)
+graph_symbol_to_utf8(const struct graph_symbol *symbol)
 {
 	if (symbol->commit) {
 		if (symbol->boundary)
@@ -888,7 +1175,7 @@ graph_symbol_to_utf8(struct graph_symbol *symbol)
 }
 
 const chtype *
-graph_symbol_to_chtype(struct graph_symbol *symbol)
+graph_symbol_to_chtype(const struct graph_symbol *symbol)
 {
 	static chtype graphics[2];
 
@@ -951,7 +1238,7 @@ graph_symbol_to_chtype(struct graph_symbol *symbol)
 }
 
 const char *
-graph_symbol_to_ascii(struct graph_symbol *symbol)
+graph_symbol_to_ascii(const struct graph_symbol *symbol)
 {
 	if (symbol->commit) {
 		if (symbol->boundary)
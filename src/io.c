@@ -168,9 +168,14 @@ io_done(struct io *io)
 {
 	pid_t pid = io->pid;
 
+	if (io->reads)
+		io_trace("io: %lu bytes in %lu reads, %lu bytes in %lu moves, %lu byte buffer\n",
+			 io->read_bytes, io->reads, io->moved_bytes, io->moves,
+			 (unsigned long) io->bufalloc);
 	if (io->pipe != -1)
 		close(io->pipe);
-	free(io->buf);
+	if (!io->arena)
+		free(io->buf);
 	io_init(io);
 
 	while (pid > 0) {
@@ -377,7 +382,7 @@ io_strerror(struct io *io)
 bool
 io_can_read(struct io *io, bool can_block)
 {
-	struct timeval tv = { 0, 500 };
+	struct timeval tv = { 0, 0 };
 	fd_set fds;
 
 	FD_ZERO(&fds);
@@ -404,54 +409,132 @@ io_read(struct io *io, void *buf, size_t bufsize)
 
 DEFINE_ALLOCATOR(io_realloc_buf, char, BUFSIZ)
 
-char *
-io_get(struct io *io, int c, bool can_read)
+#define IO_ARENA_BUFSIZE	(256 * 1024)
+#define IO_MAX_BUFSIZE		(4 * 1024 * 1024)
+
+static void
+io_move_buf(struct io *io, char *buf)
+{
+	if (io->bufsize) {
+		memmove(buf, io->bufpos, io->bufsize);
+		io->moves++;
+		io->moved_bytes += io->bufsize;
+	}
+	io->bufpos = buf;
+}
+
+/* Make room for reading more data. Lines read into an arena must stay
+ * where they are, so instead of moving the buffer content only the
+ * partial line at the end is copied to a new buffer once the current
+ * one is full. */
+static bool
+io_reserve_buf(struct io *io)
+{
+	size_t bufalloc, avail;
+	char *buf;
+
+	if (io->arena) {
+		if (io->buf && io->bufpos + io->bufsize < io->buf + io->bufalloc)
+			return TRUE;
+
+		/* Leave room for terminating the last line. */
+		bufalloc = MAX(IO_ARENA_BUFSIZE, io->bufsize * 2);
+		buf = arena_alloc(io->arena, bufalloc + 1);
+		if (!buf)
+			return FALSE;
+		io_move_buf(io, buf);
+		io->buf = buf;
+		io->bufalloc = bufalloc;
+		return TRUE;
+	}
+
+	if (!io->bufsize)
+		io->bufpos = io->buf;
+
+	/* Keep reading into the free space at the end of the buffer and
+	 * only move the partial line at the end to the front once less
+	 * than half of the buffer is left. */
+	avail = io->buf + io->bufalloc - io->bufpos - io->bufsize;
+	if (avail && avail >= io->bufalloc / 2)
+		return TRUE;
+
+	/* Double the buffer while reads fill it up, i.e. while the other
+	 * end writes faster than the lines are being read, or if a single
+	 * line doesn't leave room for reading more. */
+	if (!io->bufalloc || (io->full_read && io->bufalloc < IO_MAX_BUFSIZE) ||
+	    io->bufsize > io->bufalloc / 2) {
+		bufalloc = io->bufalloc ? io->bufalloc * 2 : BUFSIZ;
+		buf = malloc(bufalloc);
+		if (!buf)
+			return FALSE;
+		io_move_buf(io, buf);
+		free(io->buf);
+		io->buf = buf;
+		io->bufalloc = bufalloc;
+		return TRUE;
+	}
+
+	io_move_buf(io, io->buf);
+	return TRUE;
+}
+
+/* Get the next line ending with c. The line is NUL terminated and stays
+ * valid until the next call, or as long as the arena if one is used. */
+bool
+io_get_buffer(struct io *io, struct buffer *buf, int c, bool can_read)
 {
 	char *eol;
 	ssize_t readsize;
+	size_t avail;
 
 	while (TRUE) {
 		if (io->bufsize > 0) {
 			eol = memchr(io->bufpos, c, io->bufsize);
 			if (eol) {
-				char *line = io->bufpos;
+				buf->data = io->bufpos;
+				buf->size = eol - io->bufpos;
 
 				*eol = 0;
 				io->bufpos = eol + 1;
-				io->bufsize -= io->bufpos - line;
-				return line;
+				io->bufsize -= buf->size + 1;
+				return TRUE;
 			}
 		}
 
 		if (io_eof(io)) {
 			if (io->bufsize) {
+				buf->data = io->bufpos;
+				buf->size = io->bufsize;
+
 				io->bufpos[io->bufsize] = 0;
 				io->bufsize = 0;
-				return io->bufpos;
+				return TRUE;
 			}
-			return NULL;
+			return FALSE;
 		}
 
-		if (!can_read)
-			return NULL;
-
-		if (io->bufsize > 0 && io->bufpos > io->buf)
-			memmove(io->buf, io->bufpos, io->bufsize);
-
-		if (io->bufalloc == io->bufsize) {
-			if (!io_realloc_buf(&io->buf, io->bufalloc, BUFSIZ))
-				return NULL;
-			io->bufalloc += BUFSIZ;
-		}
+		if (!can_read || !io_reserve_buf(io))
+			return FALSE;
 
-		io->bufpos = io->buf;
-		readsize = io_read(io, io->buf + io->bufsize, io->bufalloc - io->bufsize);
+		avail = io->buf + io->bufalloc - io->bufpos - io->bufsize;
+		readsize = io_read(io, io->bufpos + io->bufsize, avail);
 		if (io_error(io))
-			return NULL;
+			return FALSE;
 		io->bufsize += readsize;
+		io->full_read = readsize == avail;
+		io->reads++;
+		io->read_bytes += readsize;
 	}
 }
 
+char *
+io_get(struct io *io, int c, bool can_read)
+{
+	struct buffer buf;
+
+	return io_get_buffer(io, &buf, c, can_read) ? buf.data : NULL;
+}
+
 bool
 io_write(struct io *io, const void *buf, size_t bufsize)
 {
@@ -472,6 +555,36 @@ io_write(struct io *io, const void *buf, size_t bufsize)
 	return written == bufsize;
 }
 
+/* Write as much as the pipe accepts without blocking. Returns the number
+ * of bytes written or -1 on errors. The pipe is left blocking. */
+ssize_t
+io_write_some(struct io *io, const void *buf, size_t bufsize)
+{
+	int flags = fcntl(io->pipe, F_GETFL);
+	ssize_t size;
+
+	if (flags == -1 || fcntl(io->pipe, F_SETFL, flags | O_NONBLOCK) == -1) {
+		io->error = errno;
+		return -1;
+	}
+
+	do {
+		size = write(io->pipe, buf, bufsize);
+	} while (size < 0 && errno == EINTR);
+
+	if (size < 0 && errno == EAGAIN)
+		size = 0;
+	else if (size < 0)
+		io->error = errno;
+
+	if (fcntl(io->pipe, F_SETFL, flags) == -1 && size >= 0) {
+		io->error = errno;
+		return -1;
+	}
+
+	return size;
+}
+
 bool
 io_printf(struct io *io, const char *fmt, ...)
 {
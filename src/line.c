@@ -23,22 +23,64 @@ static size_t line_rules;
 static struct line_info **color_pair;
 static size_t color_pairs;
 
+/* Rules indexed by the lower case first byte of the line they match.
+ * Entries are rule numbers plus one, so zero ends a chain. */
+static size_t line_rule_first[256];
+static size_t *line_rule_next;
+static bool line_rule_indexed;
+
 DEFINE_ALLOCATOR(realloc_line_rule, struct line_rule, 8)
+DEFINE_ALLOCATOR(realloc_line_rule_next, size_t, 8)
 DEFINE_ALLOCATOR(realloc_color_pair, struct line_info *, 8)
 
-enum line_type
-get_line_type(const char *line)
+static bool
+index_line_rules(void)
 {
-	int linelen = strlen(line);
+	size_t *last[ARRAY_SIZE(line_rule_first)];
 	enum line_type type;
+	int i;
+
+	if (!realloc_line_rule_next(&line_rule_next, 0, line_rules))
+		return FALSE;
 
+	for (i = 0; i < ARRAY_SIZE(line_rule_first); i++) {
+		line_rule_first[i] = 0;
+		last[i] = &line_rule_first[i];
+	}
+
+	/* Chain the rules in order so the first matching rule wins. */
 	for (type = 0; type < line_rules; type++) {
 		struct line_rule *rule = &line_rule[type];
+		unsigned char first = tolower((unsigned char) *rule->line);
+
+		line_rule_next[type] = 0;
+		if (!rule->linelen)
+			continue;
+		*last[first] = type + 1;
+		last[first] = &line_rule_next[type];
+	}
+
+	line_rule_indexed = TRUE;
+	return TRUE;
+}
+
+enum line_type
+get_line_type(const char *line)
+{
+	unsigned char first = tolower((unsigned char) *line);
+	size_t next;
+
+	if (!line_rule_indexed && !index_line_rules())
+		return LINE_DEFAULT;
+
+	for (next = line_rule_first[first]; next; next = line_rule_next[next - 1]) {
+		struct line_rule *rule = &line_rule[next - 1];
 
-		/* Case insensitive search matches Signed-off-by lines better. */
-		if (rule->linelen && linelen >= rule->linelen &&
-		    !strncasecmp(rule->line, line, rule->linelen))
-			return type;
+		/* Case insensitive search matches Signed-off-by lines better.
+		 * The first byte is known to match and a shorter line will
+		 * fail on its terminating NUL byte. */
+		if (!strncasecmp(rule->line + 1, line + 1, rule->linelen - 1))
+			return next - 1;
 	}
 
 	return LINE_DEFAULT;
@@ -90,6 +132,7 @@ init_line_info(const char *prefix, const char *name, size_t namelen, const char
 		die("Failed to allocate line info");
 
 	rule = &line_rule[line_rules++];
+	line_rule_indexed = FALSE;
 	rule->name = name;
 	rule->namelen = namelen;
 	rule->line = line;
@@ -53,6 +53,7 @@ log_open(struct view *view, enum open_flags flags)
 		"git", "log", encoding_arg, "--no-color", "--cc", "--stat", "-n100", "%(head)", "--", NULL
 	};
 
+	watch_register(&view->watch, WATCH_HEAD | WATCH_REFS);
 	return begin_update(view, NULL, log_argv, flags);
 }
 
@@ -79,7 +80,7 @@ struct view_ops log_ops = {
 	"line",
 	{ "log" },
 	argv_env.head,
-	VIEW_ADD_PAGER_REFS | VIEW_OPEN_DIFF | VIEW_SEND_CHILD_ENTER | VIEW_LOG_LIKE | VIEW_REFRESH,
+	VIEW_ADD_PAGER_REFS | VIEW_OPEN_DIFF | VIEW_SEND_CHILD_ENTER | VIEW_LOG_LIKE | VIEW_REFRESH | VIEW_KEEP_TEXT,
 	sizeof(struct log_state),
 	log_open,
 	pager_read,
@@ -20,7 +20,9 @@
 #include "tig/draw.h"
 #include "tig/git.h"
 #include "tig/status.h"
+#include "tig/cache.h"
 #include "tig/main.h"
+#include "compat/hashtab.h"
 
 /*
  * Revision graph
@@ -36,7 +38,7 @@ static const enum line_type graph_colors[] = {
 	LINE_PALETTE_6,
 };
 
-static enum line_type get_graph_color(struct graph_symbol *symbol)
+static enum line_type get_graph_color(const struct graph_symbol *symbol)
 {
 	if (symbol->commit)
 		return LINE_GRAPH_COMMIT;
@@ -45,7 +47,7 @@ static enum line_type get_graph_color(struct graph_symbol *symbol)
 }
 
 static bool
-draw_graph_utf8(struct view *view, struct graph_symbol *symbol, enum line_type color, bool first)
+draw_graph_utf8(struct view *view, const struct graph_symbol *symbol, enum line_type color, bool first)
 {
 	const char *chars = graph_symbol_to_utf8(symbol);
 
@@ -53,7 +55,7 @@ draw_graph_utf8(struct view *view, struct graph_symbol *symbol, enum line_type c
 }
 
 static bool
-draw_graph_ascii(struct view *view, struct graph_symbol *symbol, enum line_type color, bool first)
+draw_graph_ascii(struct view *view, const struct graph_symbol *symbol, enum line_type color, bool first)
 {
 	const char *chars = graph_symbol_to_ascii(symbol);
 
@@ -61,14 +63,14 @@ draw_graph_ascii(struct view *view, struct graph_symbol *symbol, enum line_type
 }
 
 static bool
-draw_graph_chtype(struct view *view, struct graph_symbol *symbol, enum line_type color, bool first)
+draw_graph_chtype(struct view *view, const struct graph_symbol *symbol, enum line_type color, bool first)
 {
 	const chtype *chars = graph_symbol_to_chtype(symbol);
 
 	return draw_graphic(view, color, chars + !!first, 2 - !!first, FALSE);
 }
 
-typedef bool (*draw_graph_fn)(struct view *, struct graph_symbol *, enum line_type, bool);
+typedef bool (*draw_graph_fn)(struct view *, const struct graph_symbol *, enum line_type, bool);
 
 static bool draw_graph(struct view *view, struct graph_canvas *canvas)
 {
@@ -81,7 +83,7 @@ static bool draw_graph(struct view *view, struct graph_canvas *canvas)
 	int i;
 
 	for (i = 0; i < canvas->size; i++) {
-		struct graph_symbol *symbol = &canvas->symbols[i];
+		const struct graph_symbol *symbol = &canvas->symbols[i];
 		enum line_type color = get_graph_color(symbol);
 
 		if (fn(view, symbol, color, i == 0))
@@ -91,20 +93,311 @@ static bool draw_graph(struct view *view, struct graph_canvas *canvas)
 	return draw_text(view, LINE_MAIN_REVGRAPH, " ");
 }
 
+/* Only the parents of each commit are kept while loading. Graph rows
+ * are rendered when they are drawn, starting from the closest lane
+ * state saved above them. Lane states are saved every few lines as
+ * rows are rendered further down, so jumping back and forth does not
+ * render the graph from the top again. Rows which have already been
+ * rendered only update the lanes, and the table of distinct rows is
+ * kept with the view, so scrolling only allocates rows for new lines.
+ *
+ * Lane states are also stored in the commit cache. New commits above
+ * the cached commits change the lanes of the cached commits, so cached
+ * lane states are only used below the line where a rendered lane state
+ * is the same as the cached one. The rows below that line are rendered
+ * the same way as when they were cached. */
+
+#define MAIN_GRAPH_LANES	64	/* Lines between saved lane states. */
+#define MAIN_GRAPH_LOOKAHEAD	32	/* Lines to render below the view. */
+
+struct main_lanes {
+	size_t size;			/* Size of the lane state. */
+	bool cached;			/* Was it read from the commit cache? */
+	uint32_t state[1];		/* Lane state saved by the graph. */
+};
+
+static struct main_lanes *
+main_new_lanes(struct view *view, size_t size, bool cached)
+{
+	struct main_lanes *lanes = arena_alloc(&view->arena, sizeof(*lanes) + size);
+
+	if (lanes) {
+		lanes->size = size;
+		lanes->cached = cached;
+	}
+
+	return lanes;
+}
+
+static const struct main_lanes *
+main_save_lanes(struct view *view, struct graph *graph)
+{
+	struct main_lanes *lanes = main_new_lanes(view, graph_state_size(graph), FALSE);
+
+	return lanes && graph_get_state(graph, lanes->state) ? lanes : NULL;
+}
+
+static bool
+main_has_lanes(struct view *view, size_t lineno)
+{
+	struct main_state *state = view->private;
+	const struct commit *commit = view->line[lineno].data;
+
+	return commit->lanes &&
+	       (!commit->lanes->cached ||
+		(state->cached_lanes_match && lineno >= state->cached_lanes_line));
+}
+
+/* The changes commits are added above the HEAD commit, which can be
+ * anywhere in the view, and change the lanes below them. */
+static bool
+main_has_all_changes_commits(struct main_state *state)
+{
+	return state->added_changes_commits || state->commits_loaded ||
+	       !opt_show_changes || !repo.is_inside_work_tree;
+}
+
+static void
+main_compare_cached_lanes(struct view *view, struct graph *graph, size_t lineno)
+{
+	struct main_state *state = view->private;
+	struct commit *commit = view->line[lineno].data;
+	size_t size = graph_state_size(graph);
+	void *lanes;
+
+	if (lineno < state->changes_lines || !main_has_all_changes_commits(state))
+		return;
+
+	lanes = size == commit->lanes->size ? malloc(size) : NULL;
+	if (lanes && graph_get_state(graph, lanes) &&
+	    !memcmp(lanes, commit->lanes->state, size)) {
+		state->cached_lanes_match = TRUE;
+		state->cached_lanes_line = lineno;
+	} else {
+		commit->lanes = NULL;
+	}
+
+	free(lanes);
+}
+
+/* Renders the graph rows from lineno to end, or only the lanes when
+ * saving them. */
+static void
+main_render_graph(struct view *view, size_t lineno, size_t end, bool symbols)
+{
+	struct main_state *state = view->private;
+	struct graph graph = {};
+	struct commit *commit;
+	size_t from, start;
+
+	graph.arena = &view->arena;
+	graph.canvases = state->graph_canvases;
+
+	for (from = lineno; from > 0 && !main_has_lanes(view, from); from--)
+		;
+
+	commit = view->line[from].data;
+	if (from > 0 && !graph_set_state(&graph, commit->lanes->state))
+		goto out;
+
+	for (start = from; from < end; from++) {
+		commit = view->line[from].data;
+		if (commit->lanes && !main_has_lanes(view, from) && !state->cached_lanes_match) {
+			main_compare_cached_lanes(view, &graph, from);
+			/* The cached lane states cover the lines below. */
+			if (!symbols && state->cached_lanes_match)
+				break;
+		}
+		if (from > 0 && !(from % MAIN_GRAPH_LANES) && !main_has_lanes(view, from))
+			commit->lanes = main_save_lanes(view, &graph);
+
+		if (!graph_add_commit(&graph, symbols && !commit->graph.symbols ? &commit->graph : NULL,
+				      commit->id, commit->parents ? commit->parents : "", commit->is_boundary) ||
+		    !graph_render_parents(&graph))
+			break;
+	}
+
+	/* Lines rendered from a cached lane state may follow lines which
+	 * have not been rendered. */
+	if (start <= state->graph_lines)
+		state->graph_lines = MAX(state->graph_lines, from);
+
+out:
+	state->graph_canvases = graph.canvases;
+	done_graph(&graph);
+}
+
 /*
  * Main view backend
  */
 
 DEFINE_ALLOCATOR(realloc_reflogs, char *, 32)
 
+/*
+ * Commit cache
+ */
+
+#define MAIN_CACHE_NAME		"main"
+#define MAIN_CACHE_MAGIC	"TIGMAIN"
+#define MAIN_CACHE_VERSION	2
+#define MAIN_CACHE_MAX_TIPS	2048	/* Tips to pass on the command line. */
+#define MAIN_CACHE_BATCH	4096	/* Cached commits to add per update. */
+
+/* The cache file starts with the header followed by the commit rows,
+ * the author table, the tips and parent IDs, the graph lane states, the
+ * key and finally the string table. Numbers are stored in native byte
+ * order. */
+struct main_cache_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t key_size;
+	uint32_t commits;
+	uint32_t authors;
+	uint32_t tips;
+	uint32_t parents;
+	uint32_t strings_size;
+	uint32_t lanes;			/* Lane states of the graph. */
+	uint32_t lanes_size;		/* Size of all lane states. */
+	uint32_t changes;		/* First row below the changes commits. */
+	uint32_t padding;
+	int64_t newest;			/* Newest committer date. */
+};
+
+struct main_cache_id {
+	unsigned char bytes[SIZEOF_ID];
+};
+
+struct main_cache_row {
+	int64_t time;
+	int32_t tz;
+	uint32_t author;		/* Index in the author table. */
+	uint32_t title;			/* Offset in the string table. */
+	uint32_t parents;		/* Index of the first parent ID. */
+	struct main_cache_id id;
+	unsigned char padding[4];
+};
+
+struct main_cache_author {
+	uint32_t name;			/* Offset in the string table. */
+	uint32_t email;			/* Offset in the string table. */
+};
+
+struct main_cache_lanes {
+	uint32_t row;			/* Row of the commit below the lanes. */
+	uint32_t offset;		/* Offset in the lane states. */
+};
+
+struct main_cache {
+	/* The cache file with commits to add after the new commits. */
+	struct cache_file file;
+	const struct main_cache_header *header;
+	const struct main_cache_row *rows;
+	const struct main_cache_author *authors;
+	const struct main_cache_id *tips;
+	const struct main_cache_id *parents;
+	const struct main_cache_lanes *lanes;
+	const char *lane_states;
+	const char *strings;
+	const struct ident **idents;	/* Authors looked up so far. */
+	size_t replayed;
+	size_t replayed_lanes;
+	char *ids;			/* Commit and parent IDs of a cached commit. */
+	size_t ids_size;
+
+	/* Parents of all loaded commits, used to write the cache file. */
+	struct main_cache_id *commit_parents;
+	size_t commit_parents_size;
+	size_t added_parents;
+	uint32_t *commits;		/* Index of each commit's first parent. */
+	size_t commits_size;
+	int64_t newest;
+	bool failed;
+};
+
+DEFINE_ALLOCATOR(realloc_cache_ids, char, SIZEOF_STR)
+DEFINE_ALLOCATOR(realloc_cache_parents, struct main_cache_id, 1024)
+DEFINE_ALLOCATOR(realloc_cache_commits, uint32_t, 1024)
+
+static void
+main_cache_add_parents(struct main_cache *cache, const char *ids)
+{
+	const char *parent = ids;
+
+	/* Forget parents registered for commits that were never added,
+	 * e.g. the staged and unstaged changes commits. */
+	cache->commit_parents_size = cache->added_parents;
+
+	while ((parent = strchr(parent, ' '))) {
+		struct main_cache_id *id;
+
+		if (!realloc_cache_parents(&cache->commit_parents, cache->commit_parents_size, 1)) {
+			cache->failed = TRUE;
+			return;
+		}
+
+		id = &cache->commit_parents[cache->commit_parents_size++];
+		if (!string_rev_to_id(id->bytes, ++parent))
+			cache->failed = TRUE;
+	}
+}
+
+static void
+main_cache_add_committer(struct main_cache *cache, const char *committer)
+{
+	const char *emailend = strrchr(committer, '>');
+
+	if (emailend && emailend[1] == ' ') {
+		int64_t time = strtoll(emailend + 2, NULL, 10);
+
+		if (cache->newest < time)
+			cache->newest = time;
+	}
+}
+
+static void
+main_cache_add_commit(struct main_cache *cache)
+{
+	if (!realloc_cache_commits(&cache->commits, cache->commits_size, 1)) {
+		cache->failed = TRUE;
+		return;
+	}
+
+	cache->commits[cache->commits_size++] = cache->added_parents;
+	cache->added_parents = cache->commit_parents_size;
+}
+
 static void
 main_register_commit(struct view *view, struct commit *commit, const char *ids, bool is_boundary)
 {
 	struct main_state *state = view->private;
 
 	string_copy_rev(commit->id, ids);
-	if (state->with_graph)
-		graph_add_commit(&state->graph, &commit->graph, commit->id, ids, is_boundary);
+	if (state->with_graph) {
+		const char *parents = ids + strlen(commit->id);
+
+		commit->parents = arena_strndup(&view->arena, parents, strlen(parents));
+		commit->is_boundary = is_boundary;
+		if (*parents)
+			state->has_parents = TRUE;
+	}
+	if (state->cache)
+		main_cache_add_parents(state->cache, ids);
+}
+
+/* Adds a parent listed on a parent line to the current commit. */
+static void
+main_add_parent(struct view *view, struct commit *commit, const char *parent)
+{
+	const char *parents = commit->parents ? commit->parents : "";
+	size_t parentslen = strlen(parents);
+	char *copy = arena_alloc(&view->arena, parentslen + strlen(parent) + 2);
+
+	if (copy) {
+		memcpy(copy, parents, parentslen);
+		copy[parentslen] = ' ';
+		strcpy(copy + parentslen + 1, parent);
+		commit->parents = copy;
+	}
 }
 
 static struct commit *
@@ -125,11 +418,21 @@ main_add_commit(struct view *view, enum line_type type, struct commit *template,
 	if (!add_line_alloc(view, &commit, type, titlelen, custom))
 		return NULL;
 
+	if (state->cache && !custom)
+		main_cache_add_commit(state->cache);
+
 	*commit = *template;
 	strncpy(commit->title, title, titlelen);
-	state->graph.canvas = &commit->graph;
 	memset(template, 0, sizeof(*template));
 	state->reflogmsg[0] = 0;
+
+	if (*state->jump_id && commit->author &&
+	    !strncmp(commit->id, state->jump_id, strlen(state->jump_id))) {
+		state->jump_id[0] = 0;
+		select_view_line(view, view->lines - 1);
+		report_clear();
+	}
+
 	return commit;
 }
 
@@ -155,7 +458,6 @@ static void
 main_add_changes_commit(struct view *view, enum line_type type, const char *parent, const char *title)
 {
 	char ids[SIZEOF_STR] = NULL_ID " ";
-	struct main_state *state = view->private;
 	struct commit commit = {};
 	struct timeval now;
 	struct timezone tz;
@@ -172,8 +474,7 @@ main_add_changes_commit(struct view *view, enum line_type type, const char *pare
 
 	commit.author = &unknown_ident;
 	main_register_commit(view, &commit, ids, FALSE);
-	if (main_add_commit(view, type, &commit, title, TRUE) && state->with_graph)
-		graph_render_parents(&state->graph);
+	main_add_commit(view, type, &commit, title, TRUE);
 }
 
 static void
@@ -202,6 +503,598 @@ main_add_changes_commits(struct view *view, struct main_state *state, const char
 
 	main_add_changes_commit(view, LINE_STAT_STAGED, staged_parent, "Staged changes");
 	main_add_changes_commit(view, LINE_STAT_UNSTAGED, unstaged_parent, "Unstaged changes");
+	if (staged_parent || unstaged_parent)
+		state->changes_lines = view->lines;
+}
+
+static void
+main_cache_free(struct main_state *state)
+{
+	struct main_cache *cache = state->cache;
+
+	if (!cache)
+		return;
+
+	cache_unmap(&cache->file);
+	free(cache->idents);
+	free(cache->ids);
+	free(cache->commit_parents);
+	free(cache->commits);
+	free(cache);
+	state->cache = NULL;
+}
+
+/* Commits can only be cached when loading everything reachable from
+ * the revisions, since new commits are found by excluding the commits
+ * reachable from the cached tips. */
+static bool
+main_cache_enabled(enum open_flags flags)
+{
+	int i;
+
+	if (!opt_main_cache || (flags & OPEN_PAGER_MODE) ||
+	    opt_commit_order == COMMIT_ORDER_REVERSE ||
+	    argv_size(opt_cmdline_argv) || argv_size(opt_file_argv))
+		return FALSE;
+
+	for (i = 0; opt_rev_argv && opt_rev_argv[i]; i++)
+		if (*opt_rev_argv[i] == '-' || *opt_rev_argv[i] == '^')
+			return FALSE;
+
+	return TRUE;
+}
+
+static const char *
+main_cache_key(void)
+{
+	static char key[SIZEOF_STR];
+
+	if (!string_format(key, "%s %s", encoding_arg, commit_order_arg()))
+		return NULL;
+	return key;
+}
+
+static bool
+main_cache_append_tips(const char ***argv, struct main_cache *cache)
+{
+	char rev[SIZEOF_REV];
+	size_t i;
+
+	for (i = 0; i < cache->header->tips; i++) {
+		string_id_to_rev(rev, cache->tips[i].bytes);
+		if (!argv_append(argv, rev))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static bool
+main_cache_check(struct main_cache *cache, const char *key)
+{
+	const struct main_cache_header *header = (const void *) cache->file.data;
+	const char *data = (const char *) (header + 1);
+	size_t size, i;
+
+	if (cache->file.size < sizeof(*header) ||
+	    memcmp(header->magic, MAIN_CACHE_MAGIC, sizeof(header->magic)) ||
+	    header->version != MAIN_CACHE_VERSION)
+		return FALSE;
+
+	size = sizeof(*header)
+	     + header->commits * sizeof(*cache->rows)
+	     + header->authors * sizeof(*cache->authors)
+	     + ((size_t) header->tips + header->parents) * sizeof(*cache->tips)
+	     + header->lanes * sizeof(*cache->lanes) + header->lanes_size
+	     + header->key_size + header->strings_size;
+
+	if (size != cache->file.size || !header->commits || !header->tips ||
+	    !header->strings_size ||
+	    header->key_size != strlen(key))
+		return FALSE;
+
+	cache->rows = (const void *) data;
+	data += header->commits * sizeof(*cache->rows);
+	cache->authors = (const void *) data;
+	data += header->authors * sizeof(*cache->authors);
+	cache->tips = (const void *) data;
+	data += header->tips * sizeof(*cache->tips);
+	cache->parents = (const void *) data;
+	data += header->parents * sizeof(*cache->parents);
+	cache->lanes = (const void *) data;
+	data += header->lanes * sizeof(*cache->lanes);
+	cache->lane_states = data;
+	data += header->lanes_size;
+	if (memcmp(data, key, header->key_size))
+		return FALSE;
+	cache->strings = data + header->key_size;
+
+	if (cache->strings[header->strings_size - 1])
+		return FALSE;
+
+	for (i = 0; i < header->authors; i++)
+		if (cache->authors[i].name >= header->strings_size ||
+		    cache->authors[i].email >= header->strings_size)
+			return FALSE;
+
+	for (i = 0; i < header->commits; i++) {
+		const struct main_cache_row *row = &cache->rows[i];
+		uint32_t parents = i + 1 < header->commits ? row[1].parents : header->parents;
+
+		if (row->author >= header->authors ||
+		    row->title >= header->strings_size ||
+		    row->parents > parents || parents > header->parents)
+			return FALSE;
+	}
+
+	for (i = 0; i < header->lanes; i++) {
+		const struct main_cache_lanes *lanes = &cache->lanes[i];
+		uint32_t end = i + 1 < header->lanes ? lanes[1].offset : header->lanes_size;
+
+		if (lanes->row >= header->commits || (i > 0 && lanes->row <= lanes[-1].row) ||
+		    (i == 0 && lanes->offset) || lanes->offset % sizeof(uint32_t) ||
+		    lanes->offset > end || end > header->lanes_size ||
+		    !graph_check_state(cache->lane_states + lanes->offset, end - lanes->offset))
+			return FALSE;
+	}
+
+	cache->header = header;
+	return TRUE;
+}
+
+static bool
+main_cache_append_revs(const char ***argv)
+{
+	if (argv_size(opt_rev_argv))
+		return argv_append_array(argv, opt_rev_argv);
+	return argv_append(argv, "HEAD");
+}
+
+static bool
+main_cache_rev_list_is_empty(struct main_cache *cache, const char *option, bool from_tips)
+{
+	const char *rev_list_argv[] = { "git", "rev-list", "--count", option, NULL };
+	const char **argv = NULL;
+	char count[SIZEOF_STR] = "";
+	bool ok;
+
+	if (from_tips)
+		ok = argv_append_array(&argv, rev_list_argv) &&
+		     main_cache_append_tips(&argv, cache) &&
+		     argv_append(&argv, "--not") &&
+		     main_cache_append_revs(&argv);
+	else
+		ok = argv_append_array(&argv, rev_list_argv) &&
+		     main_cache_append_revs(&argv) &&
+		     argv_append(&argv, "--not") &&
+		     main_cache_append_tips(&argv, cache);
+
+	ok = ok && io_run_buf(argv, count, sizeof(count)) && !strcmp(count, "0");
+
+	argv_free(argv);
+	free(argv);
+	return ok;
+}
+
+/* The cached commits can be reused if the cached tips are still
+ * reachable from the revisions being loaded and all new commits are
+ * newer than the cached commits, so Git would list them first. */
+static bool
+main_cache_is_current(struct main_cache *cache)
+{
+	char min_age[SIZEOF_STR];
+
+	return string_format(min_age, "--min-age=%lld", (long long) cache->header->newest) &&
+	       main_cache_rev_list_is_empty(cache, "", TRUE) &&
+	       main_cache_rev_list_is_empty(cache, min_age, FALSE);
+}
+
+static bool
+main_cache_load(struct main_cache *cache)
+{
+	static bool reported;
+	const char *key = main_cache_key();
+
+	if (!key || !cache_map(&cache->file, MAIN_CACHE_NAME))
+		return FALSE;
+
+	if (main_cache_check(cache, key)) {
+		/* The tips are passed on the command line, so all commits
+		 * are loaded from Git if there are too many of them. */
+		if (cache->header->tips > MAIN_CACHE_MAX_TIPS) {
+			if (!reported)
+				report("Not using the main view cache, which has more than %d branch tips",
+				       MAIN_CACHE_MAX_TIPS);
+			reported = TRUE;
+
+		} else if (main_cache_is_current(cache)) {
+			cache->idents = calloc(cache->header->authors, sizeof(*cache->idents));
+			cache->newest = cache->header->newest;
+			if (cache->idents)
+				return TRUE;
+		}
+	}
+
+	cache->header = NULL;
+	cache_unmap(&cache->file);
+	return FALSE;
+}
+
+/* Only let Git list commits which are not reachable from the tips of
+ * the cached commits. */
+static bool
+main_cache_argv(const char ***argv, const char *main_argv[], struct main_cache *cache)
+{
+	int i;
+
+	for (i = 0; main_argv[i]; i++) {
+		if (!strcmp(main_argv[i], "%(revargs)")) {
+			if (!main_cache_append_revs(argv) ||
+			    !argv_append(argv, "--not") ||
+			    !main_cache_append_tips(argv, cache))
+				return FALSE;
+		} else if (!argv_append(argv, main_argv[i])) {
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Copy the lane state above a cached commit, unless the changes
+ * commits were below it when it was cached. */
+static const struct main_lanes *
+main_cache_get_lanes(struct view *view, struct main_cache *cache, uint32_t row)
+{
+	const struct main_cache_header *header = cache->header;
+	const struct main_cache_lanes *lanes = &cache->lanes[cache->replayed_lanes];
+	struct main_lanes *copy;
+	size_t size;
+
+	if (cache->replayed_lanes >= header->lanes || lanes->row != row)
+		return NULL;
+
+	size = (++cache->replayed_lanes < header->lanes ? lanes[1].offset : header->lanes_size)
+	     - lanes->offset;
+	if (row < header->changes || !(copy = main_new_lanes(view, size, TRUE)))
+		return NULL;
+
+	memcpy(copy->state, cache->lane_states + lanes->offset, size);
+	return copy;
+}
+
+static const struct ident *
+main_cache_get_author(struct main_cache *cache, uint32_t index)
+{
+	if (!cache->idents[index]) {
+		const struct main_cache_author *author = &cache->authors[index];
+
+		cache->idents[index] = get_author(cache->strings + author->name,
+						  cache->strings + author->email);
+	}
+
+	return cache->idents[index];
+}
+
+/* Add the next batch of cached commits after the new commits. Returns
+ * TRUE while cached commits remain to be added. */
+static bool
+main_cache_replay(struct view *view, struct main_state *state)
+{
+	struct main_cache *cache = state->cache;
+	const struct main_cache_header *header = cache->header;
+	size_t end = MIN(cache->replayed + MAIN_CACHE_BATCH, header->commits);
+
+	for (; cache->replayed < end; cache->replayed++) {
+		const struct main_cache_row *row = &cache->rows[cache->replayed];
+		uint32_t parents = cache->replayed + 1 < header->commits
+				 ? row[1].parents : header->parents;
+		size_t idslen = (parents - row->parents + 1) * SIZEOF_REV;
+		struct commit *commit = &state->current;
+		char *ids;
+		uint32_t i;
+
+		if (idslen > cache->ids_size) {
+			if (!realloc_cache_ids(&cache->ids, cache->ids_size, idslen - cache->ids_size))
+				break;
+			cache->ids_size = idslen;
+		}
+
+		string_id_to_rev(cache->ids, row->id.bytes);
+		for (i = row->parents, ids = cache->ids; i < parents; i++) {
+			ids += SIZEOF_REV - 1;
+			*ids++ = ' ';
+			string_id_to_rev(ids, cache->parents[i].bytes);
+		}
+
+		if (!state->added_changes_commits && opt_show_changes && repo.is_inside_work_tree)
+			main_add_changes_commits(view, state, cache->ids);
+
+		main_register_commit(view, commit, cache->ids, FALSE);
+		commit->author = main_cache_get_author(cache, row->author);
+		commit->time.sec = row->time;
+		commit->time.tz = row->tz;
+
+		if (!commit->author ||
+		    !(commit = main_add_commit(view, LINE_MAIN_COMMIT, commit, cache->strings + row->title, FALSE)))
+			break;
+
+		if (state->with_graph)
+			commit->lanes = main_cache_get_lanes(view, cache, cache->replayed);
+	}
+
+	if (cache->replayed < end) {
+		memset(&state->current, 0, sizeof(state->current));
+		cache->failed = TRUE;
+		return FALSE;
+	}
+
+	return cache->replayed < header->commits;
+}
+
+struct main_cache_author_index {
+	const struct ident *ident;
+	uint32_t index;
+};
+
+static hashval_t
+main_cache_author_hash(const void *entry)
+{
+	return htab_hash_pointer(((const struct main_cache_author_index *) entry)->ident);
+}
+
+static int
+main_cache_author_eq(const void *entry, const void *ident)
+{
+	return ((const struct main_cache_author_index *) entry)->ident == ident;
+}
+
+static hashval_t
+main_cache_id_hash(const void *entry)
+{
+	hashval_t hash;
+
+	memcpy(&hash, entry, sizeof(hash));
+	return hash;
+}
+
+static int
+main_cache_id_eq(const void *entry, const void *id)
+{
+	return !memcmp(entry, id, SIZEOF_ID);
+}
+
+DEFINE_ALLOCATOR(realloc_cache_idents, const struct ident *, 256)
+
+/* Lane states rendered after new commits are saved along with the
+ * cached lane states they matched, so skip lane states close to the
+ * previous one. */
+static bool
+main_cache_has_lanes(struct view *view, size_t lineno, size_t row, size_t *next_row)
+{
+	if (row < *next_row || !main_has_lanes(view, lineno))
+		return FALSE;
+
+	*next_row = row + MAIN_GRAPH_LANES / 2;
+	return TRUE;
+}
+
+/* Write all loaded commits to the cache file. Commits which are not
+ * the parent of any other commit become the tips of the cache. */
+static void
+main_cache_save(struct view *view, struct main_state *state)
+{
+	struct main_cache *cache = state->cache;
+	struct main_cache_header header = { MAIN_CACHE_MAGIC, MAIN_CACHE_VERSION };
+	struct main_cache_id *tips = NULL;
+	const struct ident **idents = NULL;
+	const char *key = main_cache_key();
+	htab_t authors = NULL, parents = NULL;
+	struct arena arena = {};
+	struct cache_writer writer;
+	size_t strings_size = 0, lanes_size = 0;
+	size_t lineno, next_row = 0, i;
+	bool ok;
+
+	if (!key)
+		return;
+
+	authors = htab_create_alloc(256, main_cache_author_hash, main_cache_author_eq, NULL, calloc, free);
+	parents = htab_create_alloc(cache->commit_parents_size + 1, main_cache_id_hash, main_cache_id_eq, NULL, calloc, free);
+	if (!authors || !parents)
+		goto out;
+
+	for (i = 0; i < cache->added_parents; i++) {
+		void **slot = htab_find_slot(parents, &cache->commit_parents[i], INSERT);
+
+		if (!slot)
+			goto out;
+		*slot = &cache->commit_parents[i];
+	}
+
+	for (lineno = 0; lineno < view->lines; lineno++) {
+		const struct commit *commit = view->line[lineno].data;
+		struct main_cache_author_index *author;
+		struct main_cache_id id;
+		void **slot;
+
+		if (view->line[lineno].type == LINE_STAT_STAGED ||
+		    view->line[lineno].type == LINE_STAT_UNSTAGED)
+			header.changes = header.commits;
+
+		if (view->line[lineno].type != LINE_MAIN_COMMIT)
+			continue;
+
+		if (state->with_graph && main_cache_has_lanes(view, lineno, header.commits, &next_row)) {
+			header.lanes++;
+			lanes_size += commit->lanes->size;
+		}
+
+		if (!commit->author || header.commits >= cache->commits_size ||
+		    !string_rev_to_id(id.bytes, commit->id))
+			goto out;
+
+		if (!htab_find(parents, &id)) {
+			if (!realloc_cache_parents(&tips, header.tips, 1))
+				goto out;
+			tips[header.tips++] = id;
+		}
+
+		slot = htab_find_slot_with_hash(authors, commit->author,
+						htab_hash_pointer(commit->author), INSERT);
+		if (!slot)
+			goto out;
+		if (!*slot) {
+			if (!realloc_cache_idents(&idents, header.authors, 1) ||
+			    !(author = arena_alloc(&arena, sizeof(*author))))
+				goto out;
+			author->ident = commit->author;
+			author->index = header.authors;
+			idents[header.authors++] = commit->author;
+			*slot = author;
+		}
+
+		strings_size += strlen(commit->title) + 1;
+		header.commits++;
+	}
+
+	for (i = 0; i < header.authors; i++)
+		strings_size += strlen(idents[i]->name) + strlen(idents[i]->email) + 2;
+
+	if (!header.commits || strings_size > UINT32_MAX || lanes_size > UINT32_MAX)
+		goto out;
+
+	header.key_size = strlen(key);
+	header.newest = cache->newest;
+	header.parents = cache->added_parents;
+	header.strings_size = strings_size;
+	header.lanes_size = lanes_size;
+
+	if (!cache_write_begin(&writer, MAIN_CACHE_NAME))
+		goto out;
+
+	ok = cache_write(&writer, &header, sizeof(header));
+
+	for (lineno = 0, i = 0, strings_size = 0; ok && lineno < view->lines; lineno++) {
+		const struct commit *commit = view->line[lineno].data;
+		struct main_cache_author_index *author;
+		struct main_cache_row row = {};
+
+		if (view->line[lineno].type != LINE_MAIN_COMMIT)
+			continue;
+
+		author = htab_find_with_hash(authors, commit->author,
+					     htab_hash_pointer(commit->author));
+		string_rev_to_id(row.id.bytes, commit->id);
+		row.time = commit->time.sec;
+		row.tz = commit->time.tz;
+		row.author = author->index;
+		row.title = strings_size;
+		row.parents = cache->commits[i++];
+		strings_size += strlen(commit->title) + 1;
+		ok = cache_write(&writer, &row, sizeof(row));
+	}
+
+	for (i = 0; ok && i < header.authors; i++) {
+		struct main_cache_author author;
+
+		author.name = strings_size;
+		strings_size += strlen(idents[i]->name) + 1;
+		author.email = strings_size;
+		strings_size += strlen(idents[i]->email) + 1;
+		ok = cache_write(&writer, &author, sizeof(author));
+	}
+
+	ok = ok && cache_write(&writer, tips, header.tips * sizeof(*tips))
+		&& cache_write(&writer, cache->commit_parents, header.parents * sizeof(*tips));
+
+	for (lineno = 0, i = 0, next_row = 0, lanes_size = 0; ok && header.lanes && lineno < view->lines; lineno++) {
+		const struct commit *commit = view->line[lineno].data;
+		struct main_cache_lanes lanes;
+
+		if (view->line[lineno].type != LINE_MAIN_COMMIT)
+			continue;
+
+		if (main_cache_has_lanes(view, lineno, i, &next_row)) {
+			lanes.row = i;
+			lanes.offset = lanes_size;
+			lanes_size += commit->lanes->size;
+			ok = cache_write(&writer, &lanes, sizeof(lanes));
+		}
+		i++;
+	}
+
+	for (lineno = 0, i = 0, next_row = 0; ok && header.lanes && lineno < view->lines; lineno++) {
+		const struct commit *commit = view->line[lineno].data;
+
+		if (view->line[lineno].type != LINE_MAIN_COMMIT)
+			continue;
+
+		if (main_cache_has_lanes(view, lineno, i++, &next_row))
+			ok = cache_write(&writer, commit->lanes->state, commit->lanes->size);
+	}
+
+	ok = ok && cache_write(&writer, key, header.key_size);
+
+	for (lineno = 0; ok && lineno < view->lines; lineno++) {
+		const struct commit *commit = view->line[lineno].data;
+
+		if (view->line[lineno].type == LINE_MAIN_COMMIT)
+			ok = cache_write(&writer, commit->title, strlen(commit->title) + 1);
+	}
+
+	for (i = 0; ok && i < header.authors; i++)
+		ok = cache_write(&writer, idents[i]->name, strlen(idents[i]->name) + 1) &&
+		     cache_write(&writer, idents[i]->email, strlen(idents[i]->email) + 1);
+
+	if (!cache_write_end(&writer, ok))
+		report("Failed to write the main view cache");
+
+out:
+	if (authors)
+		htab_delete(authors);
+	if (parents)
+		htab_delete(parents);
+	arena_free(&arena);
+	free(idents);
+	free(tips);
+}
+
+/* Renders the lanes of the lines above the cached lane states, a batch
+ * at a time, so they can all be saved. Returns TRUE when done. */
+static bool
+main_cache_render_lanes(struct view *view, struct main_state *state)
+{
+	size_t end = MIN(state->graph_lines + MAIN_CACHE_BATCH, view->lines);
+
+	if (state->cached_lanes_match || state->graph_lines >= view->lines)
+		return TRUE;
+
+	main_render_graph(view, state->graph_lines, end, FALSE);
+	return state->cached_lanes_match || state->graph_lines < end || end == view->lines;
+}
+
+/* Called when Git has listed the new commits. */
+static bool
+main_cache_done(struct view *view, struct main_state *state)
+{
+	struct main_cache *cache = state->cache;
+	bool complete = io_eof(view->pipe) && !io_error(view->pipe);
+
+	if (complete && cache->header && !cache->failed &&
+	    main_cache_replay(view, state))
+		return FALSE;
+
+	state->commits_loaded = TRUE;
+
+	if (complete && !cache->failed && cache->commits_size > cache->replayed) {
+		if (state->with_graph && !main_cache_render_lanes(view, state))
+			return FALSE;
+		main_cache_save(view, state);
+	}
+
+	main_cache_free(state);
+	return TRUE;
 }
 
 static size_t
@@ -250,6 +1143,8 @@ main_open(struct view *view, enum open_flags flags)
 		GIT_MAIN_LOG(encoding_arg, commit_order_arg(), "%(cmdlineargs)", "%(revargs)", "%(fileargs)")
 	};
 	struct main_state *state = view->private;
+	const char **argv = NULL;
+	bool ok;
 
 	state->with_graph = opt_show_rev_graph &&
 			    opt_commit_order != COMMIT_ORDER_REVERSE;
@@ -263,7 +1158,25 @@ main_open(struct view *view, enum open_flags flags)
 		state->with_graph = FALSE;
 	}
 
-	return begin_update(view, NULL, main_argv, flags);
+	/* The index is used for the staged and unstaged changes commits. */
+	watch_register(&view->watch, WATCH_HEAD | WATCH_REFS |
+		       (opt_show_changes && repo.is_inside_work_tree ? WATCH_INDEX : WATCH_NONE));
+
+	if (main_cache_enabled(flags) && !(state->cache = calloc(1, sizeof(*state->cache))))
+		return FALSE;
+
+	if (state->cache && main_cache_load(state->cache) &&
+	    !main_cache_argv(&argv, main_argv, state->cache)) {
+		main_cache_free(state);
+		return FALSE;
+	}
+
+	ok = begin_update(view, NULL, argv ? argv : main_argv, flags);
+	if (!ok)
+		main_cache_free(state);
+	argv_free(argv);
+	free(argv);
+	return ok;
 }
 
 static void
@@ -272,15 +1185,11 @@ main_done(struct view *view)
 	struct main_state *state = view->private;
 	int i;
 
-	for (i = 0; i < view->lines; i++) {
-		struct commit *commit = view->line[i].data;
-
-		free(commit->graph.symbols);
-	}
-
 	for (i = 0; i < state->reflogs; i++)
 		free(state->reflog[i]);
 	free(state->reflog);
+	/* Freed along with the view's arena. */
+	state->graph_canvases = NULL;
 }
 
 #define MAIN_NO_COMMIT_REFS 1
@@ -328,6 +1237,12 @@ main_draw(struct view *view, struct line *line, unsigned int lineno)
 	if (draw_author(view, commit->author))
 		return TRUE;
 
+	if (state->with_graph && !commit->graph.symbols) {
+		size_t pos = line - view->line;
+
+		main_render_graph(view, pos, MIN(pos + view->height + MAIN_GRAPH_LOOKAHEAD, view->lines), TRUE);
+	}
+
 	if (state->with_graph && draw_graph(view, &commit->graph))
 		return TRUE;
 
@@ -369,27 +1284,30 @@ bool
 main_read(struct view *view, char *line)
 {
 	struct main_state *state = view->private;
-	struct graph *graph = &state->graph;
 	enum line_type type;
 	struct commit *commit = &state->current;
 
 	if (!line) {
 		main_flush_commit(view, commit);
 
+		if (state->cache && !main_cache_done(view, state))
+			return FALSE;
+		state->commits_loaded = TRUE;
+
 		if (failed_to_load_initial_view(view))
 			die("No revisions match the given arguments.");
 		if (view->lines > 0) {
 			struct commit *last = view->line[view->lines - 1].data;
 
 			view->line[view->lines - 1].dirty = 1;
-			if (!last->author) {
+			if (!last->author)
 				view->lines--;
-				free(last);
-			}
 		}
 
-		if (state->with_graph)
-			done_graph(graph);
+		if (*state->jump_id) {
+			report("Unable to find commit '%s'", state->jump_id);
+			state->jump_id[0] = 0;
+		}
 		return TRUE;
 	}
 
@@ -431,15 +1349,18 @@ main_read(struct view *view, char *line)
 		break;
 
 	case LINE_PARENT:
-		if (state->with_graph && !graph->has_parents)
-			graph_add_parent(graph, line + STRING_SIZE("parent "));
+		if (state->with_graph && !state->has_parents)
+			main_add_parent(view, commit, line + STRING_SIZE("parent "));
+		break;
+
+	case LINE_COMMITTER:
+		if (state->cache)
+			main_cache_add_committer(state->cache, line);
 		break;
 
 	case LINE_AUTHOR:
 		parse_author_line(line + STRING_SIZE("author "),
 				  &commit->author, &commit->time);
-		if (state->with_graph)
-			graph_render_parents(graph);
 		break;
 
 	default:
@@ -470,6 +1391,14 @@ main_read(struct view *view, char *line)
 	return TRUE;
 }
 
+static const char *
+main_get_id(struct line *line)
+{
+	struct commit *commit = line->data;
+
+	return commit->id;
+}
+
 enum request
 main_request(struct view *view, enum request request, struct line *line)
 {
@@ -520,19 +1449,26 @@ main_request(struct view *view, enum request request, struct line *line)
 
 	case REQ_JUMP_COMMIT:
 	{
-		int lineno;
-
-		for (lineno = 0; lineno < view->lines; lineno++) {
-			struct commit *commit = view->line[lineno].data;
-
-			if (!strncasecmp(commit->id, view->env->search, strlen(view->env->search))) {
-				select_view_line(view, lineno);
-				report_clear();
-				return REQ_NONE;
-			}
+		struct main_state *state = view->private;
+		const char *search = view->env->search;
+		struct line *commit_line = find_line_by_id(view, search, main_get_id);
+		size_t searchlen = strlen(search);
+
+		state->jump_id[0] = 0;
+		if (commit_line) {
+			select_view_line(view, commit_line - view->line);
+			report_clear();
+
+		} else if (view->pipe && searchlen < sizeof(state->jump_id)) {
+			/* Wait for the commit to be loaded. */
+			for (searchlen = 0; search[searchlen]; searchlen++)
+				state->jump_id[searchlen] = tolower(search[searchlen]);
+			state->jump_id[searchlen] = 0;
+			report("Waiting for commit '%s' to be loaded", search);
+
+		} else {
+			report("Unable to find commit '%s'", search);
 		}
-
-		report("Unable to find commit '%s'", view->env->search);
 		break;
 	}
 	default:
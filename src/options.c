@@ -391,6 +391,9 @@ option_set_command(int argc, const char *argv[])
 	if (!strcmp(argv[0], "show-changes"))
 		return parse_bool(&opt_show_changes, argv[2]);
 
+	if (!strcmp(argv[0], "main-cache"))
+		return parse_bool(&opt_main_cache, argv[2]);
+
 	if (!strcmp(argv[0], "show-notes")) {
 		bool matched = FALSE;
 		enum status_code res = parse_bool_matched(&opt_show_notes, argv[2], &matched);
@@ -434,6 +437,9 @@ option_set_command(int argc, const char *argv[])
 	if (!strcmp(argv[0], "split-view-height"))
 		return parse_step(&opt_split_view_height, argv[2]);
 
+	if (!strcmp(argv[0], "refresh-mode"))
+		return parse_enum(&opt_refresh_mode, argv[2], refresh_mode_map);
+
 	if (!strcmp(argv[0], "vertical-split"))
 		return parse_enum(&opt_vertical_split, argv[2], vertical_split_map);
 
@@ -455,6 +461,9 @@ option_set_command(int argc, const char *argv[])
 	if (!strcmp(argv[0], "status-untracked-dirs"))
 		return parse_bool(&opt_status_untracked_dirs, argv[2]);
 
+	if (!strcmp(argv[0], "status-watch"))
+		return parse_bool(&opt_status_watch, argv[2]);
+
 	if (!strcmp(argv[0], "read-git-colors"))
 		return parse_bool(&opt_read_git_colors, argv[2]);
 
@@ -226,7 +226,7 @@ struct view_ops pager_ops = {
 	"line",
 	{ "pager" },
 	"",
-	VIEW_OPEN_DIFF | VIEW_NO_REF | VIEW_NO_GIT_DIR,
+	VIEW_OPEN_DIFF | VIEW_NO_REF | VIEW_NO_GIT_DIR | VIEW_KEEP_TEXT,
 	0,
 	pager_open,
 	pager_read,
@@ -14,6 +14,7 @@
 #include "tig/tig.h"
 #include "tig/util.h"
 #include "tig/parse.h"
+#include "compat/hashtab.h"
 
 size_t
 parse_size(const char *text, int *max_digits)
@@ -238,87 +239,62 @@ parse_chunk_lineno(unsigned long *lineno, const char *chunk, int marker)
  * Caches.
  */
 
-DEFINE_ALLOCATOR(realloc_paths, const char *, 256)
-
-/* Small cache to reduce memory consumption. It uses binary search to
- * lookup or find place to position new entries. No entries are ever
+/* Small cache to reduce memory consumption. No entries are ever
  * freed. */
 const char *
 get_path(const char *path)
 {
-	static const char **paths;
-	static size_t paths_size;
-	int from = 0, to = paths_size - 1;
-	char *entry;
-
-	while (from <= to) {
-		size_t pos = (to + from) / 2;
-		int cmp = strcmp(path, paths[pos]);
-
-		if (!cmp)
-			return paths[pos];
-
-		if (cmp < 0)
-			to = pos - 1;
-		else
-			from = pos + 1;
-	}
-
-	if (!realloc_paths(&paths, paths_size, 1))
-		return NULL;
-	entry = strdup(path);
-	if (!entry)
-		return NULL;
+	static struct string_pool paths;
 
-	memmove(paths + from + 1, paths + from, (paths_size - from) * sizeof(*paths));
-	paths[from] = entry;
-	paths_size++;
+	return string_pool_intern(&paths, path, strlen(path));
+}
 
-	return entry;
+static hashval_t
+author_hash(const void *entry)
+{
+	return htab_hash_string(((const struct ident *) entry)->name);
 }
 
-DEFINE_ALLOCATOR(realloc_authors, struct ident *, 256)
+static int
+author_eq(const void *entry, const void *name)
+{
+	return !strcmp(((const struct ident *) entry)->name, name);
+}
 
-/* Small author cache to reduce memory consumption. It uses binary
- * search to lookup or find place to position new entries. No entries
- * are ever freed. */
+/* Small author cache to reduce memory consumption. Authors are looked
+ * up by name in a hash table and allocated from an arena, since no
+ * entries are ever freed. */
 struct ident *
 get_author(const char *name, const char *email)
 {
-	static struct ident **authors;
-	static size_t authors_size;
-	int from = 0, to = authors_size - 1;
+	static htab_t authors;
+	static struct arena authors_arena;
+	hashval_t hash = htab_hash_string(name);
 	struct ident *ident;
+	void **slot;
 
-	while (from <= to) {
-		size_t pos = (to + from) / 2;
-		int cmp = strcmp(name, authors[pos]->name);
-
-		if (!cmp)
-			return authors[pos];
-
-		if (cmp < 0)
-			to = pos - 1;
-		else
-			from = pos + 1;
+	if (!authors) {
+		authors = htab_create_alloc(1024, author_hash, author_eq, NULL, calloc, free);
+		if (!authors)
+			return NULL;
 	}
 
-	if (!realloc_authors(&authors, authors_size, 1))
-		return NULL;
-	ident = calloc(1, sizeof(*ident));
+	ident = htab_find_with_hash(authors, name, hash);
+	if (ident)
+		return ident;
+
+	ident = arena_alloc(&authors_arena, sizeof(*ident));
 	if (!ident)
 		return NULL;
-	ident->name = strdup(name);
-	ident->email = strdup(email);
-	if (!ident->name || !ident->email) {
-		free((void *) ident->name);
-		free(ident);
+	ident->name = arena_strndup(&authors_arena, name, strlen(name));
+	ident->email = arena_strndup(&authors_arena, email, strlen(email));
+	if (!ident->name || !ident->email)
 		return NULL;
-	}
 
-	memmove(authors + from + 1, authors + from, (authors_size - from) * sizeof(*authors));
-	authors[from] = ident;
-	authors_size++;
+	slot = htab_find_slot_with_hash(authors, name, hash, INSERT);
+	if (!slot)
+		return NULL;
+	*slot = ident;
 
 	return ident;
 }
@@ -17,13 +17,17 @@
 #include "tig/io.h"
 #include "tig/repo.h"
 #include "tig/refs.h"
+#include "compat/hashtab.h"
 
 static struct ref **refs = NULL;
 static size_t refs_size = 0;
 static struct ref *refs_head = NULL;
+static htab_t refs_by_name = NULL;
+static htab_t refs_by_replaced_id = NULL;
 
 static struct ref_list **ref_lists = NULL;
 static size_t ref_lists_size = 0;
+static htab_t ref_lists_map = NULL;
 
 DEFINE_ALLOCATOR(realloc_refs, struct ref *, 256)
 DEFINE_ALLOCATOR(realloc_refs_list, struct ref *, 8)
@@ -67,37 +71,93 @@ get_ref_head()
 	return refs_head;
 }
 
-struct ref_list *
-get_ref_list(const char *id)
+static hashval_t
+ref_list_hash(const void *entry)
+{
+	return htab_hash_string(((const struct ref_list *) entry)->id);
+}
+
+static int
+ref_list_eq(const void *entry, const void *id)
+{
+	return !strcmp(((const struct ref_list *) entry)->id, id);
+}
+
+static void
+done_ref_lists(void)
+{
+	int i;
+
+	for (i = 0; i < ref_lists_size; i++) {
+		struct ref_list *list = ref_lists[i];
+
+		free(list->refs);
+		free(list);
+	}
+
+	free(ref_lists);
+	ref_lists = NULL;
+	ref_lists_size = 0;
+
+	if (ref_lists_map)
+		htab_delete(ref_lists_map);
+	ref_lists_map = NULL;
+}
+
+/* Group the refs by commit ID. Since the refs are sorted first, each
+ * list ends up being sorted as well. */
+static bool
+init_ref_lists(void)
 {
-	struct ref_list *list;
 	size_t i;
 
-	for (i = 0; i < ref_lists_size; i++)
-		if (!strcmp(id, ref_lists[i]->id))
-			return ref_lists[i];
+	qsort(refs, refs_size, sizeof(*refs), compare_refs);
 
-	if (!realloc_ref_lists(&ref_lists, ref_lists_size, 1))
-		return NULL;
-	list = calloc(1, sizeof(*list));
-	if (!list)
-		return NULL;
-	string_copy_rev(list->id, id);
+	ref_lists_map = htab_create_alloc(refs_size, ref_list_hash, ref_list_eq, NULL, calloc, free);
+	if (!ref_lists_map)
+		return FALSE;
 
 	for (i = 0; i < refs_size; i++) {
-		if (!strcmp(id, refs[i]->id) &&
-		    realloc_refs_list(&list->refs, list->size, 1))
-			list->refs[list->size++] = refs[i];
+		struct ref *ref = refs[i];
+		struct ref_list *list;
+		void **slot;
+
+		if (!ref->id[0])
+			continue;
+
+		slot = htab_find_slot_with_hash(ref_lists_map, ref->id, htab_hash_string(ref->id), INSERT);
+		if (!slot)
+			return FALSE;
+
+		list = *slot;
+		if (!list) {
+			if (!realloc_ref_lists(&ref_lists, ref_lists_size, 1))
+				return FALSE;
+			list = calloc(1, sizeof(*list));
+			if (!list)
+				return FALSE;
+			string_copy_rev(list->id, ref->id);
+			ref_lists[ref_lists_size++] = list;
+			*slot = list;
+		}
+
+		if (!realloc_refs_list(&list->refs, list->size, 1))
+			return FALSE;
+		list->refs[list->size++] = ref;
 	}
 
-	if (!list->refs) {
-		free(list);
+	return TRUE;
+}
+
+struct ref_list *
+get_ref_list(const char *id)
+{
+	if (!ref_lists_map && !init_ref_lists()) {
+		done_ref_lists();
 		return NULL;
 	}
 
-	qsort(list->refs, list->size, sizeof(*list->refs), compare_refs);
-	ref_lists[ref_lists_size++] = list;
-	return list;
+	return htab_find_with_hash(ref_lists_map, id, htab_hash_string(id));
 }
 
 struct ref_opt {
@@ -105,21 +165,28 @@ struct ref_opt {
 	const char *head;
 };
 
-static void
-done_ref_lists(void)
+static hashval_t
+ref_name_hash(const void *entry)
 {
-	int i;
+	return htab_hash_string(((const struct ref *) entry)->name);
+}
 
-	for (i = 0; i < ref_lists_size; i++) {
-		struct ref_list *list = ref_lists[i];
+static int
+ref_name_eq(const void *entry, const void *name)
+{
+	return !strcmp(((const struct ref *) entry)->name, name);
+}
 
-		free(list->refs);
-		free(list);
-	}
+static hashval_t
+ref_id_hash(const void *entry)
+{
+	return htab_hash_string(((const struct ref *) entry)->id);
+}
 
-	free(ref_lists);
-	ref_lists = NULL;
-	ref_lists_size = 0;
+static int
+ref_id_eq(const void *entry, const void *id)
+{
+	return !strcmp(((const struct ref *) entry)->id, id);
 }
 
 static int
@@ -132,7 +199,9 @@ add_to_refs(const char *id, size_t idlen, char *name, size_t namelen, struct ref
 	bool replace = FALSE;
 	bool tracked = FALSE;
 	bool head = FALSE;
-	int pos;
+	htab_t map;
+	const char *key;
+	void **slot;
 
 	if (!prefixcmp(name, "refs/tags/")) {
 		if (!suffixcmp(name, namelen, "^{}")) {
@@ -173,19 +242,25 @@ add_to_refs(const char *id, size_t idlen, char *name, size_t namelen, struct ref
 		head = TRUE;
 	}
 
+	if (!refs_by_name) {
+		refs_by_name = htab_create_alloc(256, ref_name_hash, ref_name_eq, NULL, calloc, free);
+		refs_by_replaced_id = htab_create_alloc(8, ref_id_hash, ref_id_eq, NULL, calloc, free);
+		if (!refs_by_name || !refs_by_replaced_id)
+			return ERR;
+	}
+
 	/* If we are reloading or it's an annotated tag, replace the
 	 * previous SHA1 with the resolved commit id; relies on the fact
 	 * git-ls-remote lists the commit id of an annotated tag right
-	 * before the commit id it points to. */
-	for (pos = 0; pos < refs_size; pos++) {
-		int cmp = replace ? strcmp(id, refs[pos]->id) : strcmp(name, refs[pos]->name);
-
-		if (!cmp) {
-			ref = refs[pos];
-			break;
-		}
-	}
+	 * before the commit id it points to. Replace refs all share the
+	 * same name and are looked up by the ID they replace. */
+	map = replace ? refs_by_replaced_id : refs_by_name;
+	key = replace ? id : name;
+	slot = htab_find_slot_with_hash(map, key, htab_hash_string(key), INSERT);
+	if (!slot)
+		return ERR;
 
+	ref = *slot;
 	if (!ref) {
 		if (!realloc_refs(&refs, refs_size, 1))
 			return ERR;
@@ -194,6 +269,9 @@ add_to_refs(const char *id, size_t idlen, char *name, size_t namelen, struct ref
 			return ERR;
 		refs[refs_size++] = ref;
 		strncpy(ref->name, name, namelen);
+		if (replace)
+			string_ncopy_do(ref->id, SIZEOF_REV, id, idlen);
+		*slot = ref;
 	}
 
 	ref->valid = TRUE;
@@ -216,8 +294,525 @@ read_ref(char *id, size_t idlen, char *name, size_t namelen, void *data)
 	return add_to_refs(id, idlen, name, namelen, data);
 }
 
+/*
+ * Reading refs directly from the repository.
+ *
+ * Loose refs under refs/ take precedence over the ones in packed-refs.
+ * Anything not understood, e.g. a packed-refs file without peeled tags
+ * or refs stored outside of the git directory, makes the caller fall
+ * back to git-ls-remote.
+ */
+
+#define is_ref_id(id, idlen) \
+	((idlen) == SIZEOF_REV - 1 && strspn(id, "0123456789abcdef") >= SIZEOF_REV - 1)
+
+struct ref_file {
+	const char *name;
+	char id[SIZEOF_REV];		/* Commit or tag object ID. */
+	char peeled[SIZEOF_REV];	/* Commit ID of an annotated tag. */
+	const char *symref;		/* Target of a symbolic ref. */
+	bool loose;
+};
+
+struct ref_reader {
+	struct arena arena;
+	struct ref_file **files;
+	size_t files_size;
+	htab_t map;
+};
+
+DEFINE_ALLOCATOR(realloc_ref_files, struct ref_file *, 256)
+
+static hashval_t
+ref_file_hash(const void *entry)
+{
+	return htab_hash_string(((const struct ref_file *) entry)->name);
+}
+
+static int
+ref_file_eq(const void *entry, const void *name)
+{
+	return !strcmp(((const struct ref_file *) entry)->name, name);
+}
+
+/* Add a ref unless it is already known, which is the case for packed
+ * refs also having a loose ref file. */
+static struct ref_file *
+add_ref_file(struct ref_reader *reader, const char *name, size_t namelen, bool loose)
+{
+	char *copy = arena_strndup(&reader->arena, name, namelen);
+	struct ref_file *file;
+	void **slot;
+
+	if (!copy)
+		return NULL;
+
+	slot = htab_find_slot_with_hash(reader->map, copy, htab_hash_string(copy), INSERT);
+	if (!slot)
+		return NULL;
+	if (*slot)
+		return *slot;
+
+	file = arena_alloc(&reader->arena, sizeof(*file));
+	if (!file || !realloc_ref_files(&reader->files, reader->files_size, 1))
+		return NULL;
+
+	reader->files[reader->files_size++] = file;
+	file->name = copy;
+	file->loose = loose;
+	*slot = file;
+	return file;
+}
+
+static struct ref_file *
+find_ref_file(struct ref_reader *reader, const char *name)
+{
+	return htab_find_with_hash(reader->map, name, htab_hash_string(name));
+}
+
+/* Parse the content of a loose ref or HEAD file. */
+static bool
+parse_ref_file(struct ref_reader *reader, struct ref_file *file, const char *path)
+{
+	char buf[SIZEOF_STR];
+	ssize_t size;
+	int fd = open(path, O_RDONLY);
+
+	if (fd == -1)
+		return FALSE;
+	size = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (size <= 0)
+		return FALSE;
+
+	buf[size] = 0;
+	chomp_string(buf);
+
+	if (!prefixcmp(buf, "ref: ")) {
+		const char *target = buf + STRING_SIZE("ref: ");
+
+		file->symref = arena_strndup(&reader->arena, target, strlen(target));
+		return file->symref != NULL;
+	}
+
+	if (!is_ref_id(buf, strlen(buf)))
+		return FALSE;
+	string_copy_rev(file->id, buf);
+	return TRUE;
+}
+
+static bool
+read_loose_refs(struct ref_reader *reader, char *path, size_t pathlen, size_t namepos)
+{
+	DIR *dir = opendir(path);
+	struct dirent *entry;
+	bool ok = TRUE;
+
+	if (!dir)
+		return FALSE;
+
+	while (ok && (entry = readdir(dir))) {
+		size_t namelen = strlen(entry->d_name);
+		struct stat st;
+
+		if (entry->d_name[0] == '.' ||
+		    !suffixcmp(entry->d_name, namelen, ".lock"))
+			continue;
+
+		if (pathlen + namelen + 2 > SIZEOF_STR) {
+			ok = FALSE;
+			break;
+		}
+
+		path[pathlen] = '/';
+		memcpy(path + pathlen + 1, entry->d_name, namelen + 1);
+
+		if (stat(path, &st)) {
+			ok = FALSE;
+
+		} else if (S_ISDIR(st.st_mode)) {
+			ok = read_loose_refs(reader, path, pathlen + 1 + namelen, namepos);
+
+		} else if (S_ISREG(st.st_mode)) {
+			const char *name = path + namepos;
+			struct ref_file *file = add_ref_file(reader, name, strlen(name), TRUE);
+
+			ok = file && parse_ref_file(reader, file, path);
+		}
+	}
+
+	path[pathlen] = 0;
+	closedir(dir);
+	return ok;
+}
+
+static bool
+read_packed_refs(struct ref_reader *reader, const char *path)
+{
+	struct ref_file *file = NULL;
+	bool peeled = FALSE;
+	struct stat st;
+	char *map, *pos, *end;
+	int fd = open(path, O_RDONLY);
+
+	if (fd == -1)
+		return errno == ENOENT;
+
+	if (fstat(fd, &st)) {
+		close(fd);
+		return FALSE;
+	}
+
+	if (st.st_size == 0) {
+		close(fd);
+		return TRUE;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return FALSE;
+
+	for (pos = map, end = map + st.st_size; pos < end; ) {
+		char *eol = memchr(pos, '\n', end - pos);
+		size_t linelen = (eol ? eol : end) - pos;
+
+		if (*pos == '#') {
+			char traits[SIZEOF_STR];
+
+			/* Without peeled tags, annotated tags cannot be told
+			 * apart from plain tags. */
+			string_ncopy(traits, pos, linelen);
+			if (!prefixcmp(traits, "# pack-refs with:") &&
+			    strstr(traits, " peeled "))
+				peeled = TRUE;
+
+		} else if (*pos == '^') {
+			if (linelen < SIZEOF_REV || !is_ref_id(pos + 1, SIZEOF_REV - 1))
+				break;
+			if (file && !file->loose)
+				string_copy_rev(file->peeled, pos + 1);
+
+		} else {
+			if (!peeled || linelen <= SIZEOF_REV ||
+			    !is_ref_id(pos, SIZEOF_REV - 1) || pos[SIZEOF_REV - 1] != ' ')
+				break;
+
+			file = add_ref_file(reader, pos + SIZEOF_REV, linelen - SIZEOF_REV, FALSE);
+			if (!file)
+				break;
+			if (!file->loose)
+				string_copy_rev(file->id, pos);
+		}
+
+		pos += linelen + 1;
+	}
+
+	munmap(map, st.st_size);
+	return pos >= end;
+}
+
+/* Loose tags are not peeled, so ask git for the commits they point to.
+ * Tags are passed on the command line, a batch at a time, since git
+ * fetch stores all new tags as loose refs. */
+
+#define REF_PEEL_BATCH	1024	/* Loose tags to peel per command. */
+
+static bool
+is_loose_tag(struct ref_file *file)
+{
+	return file->loose && !file->symref && !prefixcmp(file->name, "refs/tags/");
+}
+
+static bool
+peel_loose_tags_batch(struct ref_reader *reader, size_t from, size_t to)
+{
+	const char **argv = NULL;
+	struct io io;
+	size_t i;
+	bool ok = TRUE;
+
+	if (!argv_append(&argv, "git") || !argv_append(&argv, "rev-parse"))
+		ok = FALSE;
+
+	for (i = from; ok && i < to; i++) {
+		struct ref_file *file = reader->files[i];
+		char arg[SIZEOF_REV + 3];
+
+		if (!is_loose_tag(file))
+			continue;
+		ok = string_format(arg, "%s^{}", file->id) && argv_append(&argv, arg);
+	}
+
+	if (ok && !io_run(&io, IO_RD, NULL, NULL, argv))
+		ok = FALSE;
+
+	else if (ok) {
+		for (i = from; ok && i < to; i++) {
+			struct ref_file *file = reader->files[i];
+			char *line;
+
+			if (!is_loose_tag(file))
+				continue;
+
+			line = io_get(&io, '\n', TRUE);
+			if (!line || !is_ref_id(line, strlen(line)))
+				ok = FALSE;
+			else if (strcmp(line, file->id))
+				string_copy_rev(file->peeled, line);
+		}
+
+		if (!io_done(&io))
+			ok = FALSE;
+	}
+
+	argv_free(argv);
+	free(argv);
+	return ok;
+}
+
+static bool
+peel_loose_tags(struct ref_reader *reader)
+{
+	size_t from = 0, tags = 0;
+	size_t i;
+
+	for (i = 0; i < reader->files_size; i++) {
+		if (!is_loose_tag(reader->files[i]) || ++tags < REF_PEEL_BATCH)
+			continue;
+		if (!peel_loose_tags_batch(reader, from, i + 1))
+			return FALSE;
+		from = i + 1;
+		tags = 0;
+	}
+
+	return !tags || peel_loose_tags_batch(reader, from, reader->files_size);
+}
+
+static struct ref_file *
+resolve_ref_file(struct ref_reader *reader, struct ref_file *file)
+{
+	int depth;
+
+	/* Follow symbolic refs like git does, but not forever. */
+	for (depth = 0; file && file->symref && depth < 5; depth++)
+		file = find_ref_file(reader, file->symref);
+
+	return file && !file->symref ? file : NULL;
+}
+
+static int
+read_refs_from_files(const char *git_dir, struct ref_opt *opt)
+{
+	struct ref_reader reader = {};
+	struct ref_file head = {};
+	char path[SIZEOF_STR];
+	size_t pathlen;
+	int status = ERR;
+	size_t i;
+
+	if (!string_format(path, "%s/HEAD", git_dir) ||
+	    !parse_ref_file(&reader, &head, path))
+		goto out;
+
+	if (!string_format(path, "%s/commondir", git_dir) || !access(path, F_OK) ||
+	    !string_format(path, "%s/reftable", git_dir) || !access(path, F_OK))
+		goto out;
+
+	reader.map = htab_create_alloc(1024, ref_file_hash, ref_file_eq, NULL, calloc, free);
+	if (!reader.map)
+		goto out;
+
+	if (!string_format(path, "%s/refs", git_dir))
+		goto out;
+	pathlen = strlen(path);
+	if (!read_loose_refs(&reader, path, pathlen, pathlen - STRING_SIZE("refs")) ||
+	    !string_format(path, "%s/packed-refs", git_dir) ||
+	    !read_packed_refs(&reader, path) ||
+	    !peel_loose_tags(&reader))
+		goto out;
+
+	status = OK;
+
+	if (head.symref) {
+		struct ref_file *file = resolve_ref_file(&reader, &head);
+
+		if (file)
+			string_copy_rev(head.id, file->id);
+	}
+
+	if (*head.id) {
+		char name[] = "HEAD";
+
+		status = add_to_refs(head.id, strlen(head.id), name, STRING_SIZE("HEAD"), opt);
+	}
+
+	for (i = 0; status == OK && i < reader.files_size; i++) {
+		struct ref_file *file = resolve_ref_file(&reader, reader.files[i]);
+		char name[SIZEOF_STR];
+		size_t namelen = 0;
+
+		if (!file || !string_nformat(name, sizeof(name), &namelen, "%s", reader.files[i]->name))
+			continue;
+
+		status = add_to_refs(file->id, strlen(file->id), name, namelen, opt);
+		if (status == OK && *file->peeled && !prefixcmp(reader.files[i]->name, "refs/tags/") &&
+		    string_nformat(name, sizeof(name), &namelen, "^{}"))
+			status = add_to_refs(file->peeled, strlen(file->peeled), name, namelen, opt);
+	}
+
+out:
+	if (reader.map)
+		htab_delete(reader.map);
+	free(reader.files);
+	arena_free(&reader.arena);
+	return status;
+}
+
+/* Read the branch HEAD points to, leaving it empty when detached. */
+static bool
+read_head_ref(const char *git_dir, char *head, size_t headlen)
+{
+	char path[SIZEOF_STR];
+	char buf[SIZEOF_STR];
+	ssize_t size;
+	int fd;
+
+	if (!string_format(path, "%s/HEAD", git_dir) ||
+	    (fd = open(path, O_RDONLY)) == -1)
+		return FALSE;
+
+	size = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+	if (size <= 0)
+		return FALSE;
+
+	buf[size] = 0;
+	chomp_string(buf);
+
+	if (!prefixcmp(buf, "ref: ")) {
+		const char *target = buf + STRING_SIZE("ref: ");
+
+		string_ncopy_do(head, headlen, target, strlen(target));
+		return TRUE;
+	}
+
+	return is_ref_id(buf, strlen(buf));
+}
+
+/*
+ * Detecting unchanged refs.
+ *
+ * Git updates HEAD, packed-refs and loose refs by renaming a lock file,
+ * which changes the modification time of the directory containing the
+ * ref. Comparing the stat data of the files and the directories under
+ * refs/ is thus enough to tell whether refs need to be reloaded.
+ */
+
+struct ref_stat {
+	ino_t ino;
+	off_t size;
+	time_t mtime;
+};
+
+static struct ref_stat *refs_stat;
+static size_t refs_stat_size;
+static bool refs_stat_valid;
+
+DEFINE_ALLOCATOR(realloc_ref_stat, struct ref_stat, 32)
+
+static bool
+add_ref_stat(struct ref_stat **stats, size_t *size, const char *path, bool *racy)
+{
+	struct stat st = {};
+	struct ref_stat *stat_info;
+
+	if (stat(path, &st) && errno != ENOENT)
+		return FALSE;
+
+	if (!realloc_ref_stat(stats, *size, 1))
+		return FALSE;
+
+	stat_info = &(*stats)[(*size)++];
+	stat_info->ino = st.st_ino;
+	stat_info->size = st.st_size;
+	stat_info->mtime = st.st_mtime;
+
+	/* Changes made within the same second cannot be detected. */
+	if (st.st_mtime >= time(NULL) - 1)
+		*racy = TRUE;
+	return TRUE;
+}
+
+static bool
+add_ref_dir_stats(struct ref_stat **stats, size_t *size, char *path, size_t pathlen, bool *racy)
+{
+	DIR *dir;
+	struct dirent *entry;
+	bool ok = add_ref_stat(stats, size, path, racy);
+
+	if (!ok || !(dir = opendir(path)))
+		return ok;
+
+	while (ok && (entry = readdir(dir))) {
+		size_t namelen = strlen(entry->d_name);
+		struct stat st;
+
+		if (entry->d_name[0] == '.')
+			continue;
+
+		if (pathlen + namelen + 2 > SIZEOF_STR) {
+			ok = FALSE;
+			break;
+		}
+
+		path[pathlen] = '/';
+		memcpy(path + pathlen + 1, entry->d_name, namelen + 1);
+
+		if (!stat(path, &st) && S_ISDIR(st.st_mode))
+			ok = add_ref_dir_stats(stats, size, path, pathlen + 1 + namelen, racy);
+	}
+
+	path[pathlen] = 0;
+	closedir(dir);
+	return ok;
+}
+
+/* Returns TRUE when the refs may have changed since the last check. */
+static bool
+update_refs_stat(const char *git_dir, bool use_ls_remote)
+{
+	struct ref_stat *stats = NULL;
+	size_t size = 0;
+	char path[SIZEOF_STR];
+	bool racy = FALSE;
+	bool changed = TRUE;
+
+	if (!*git_dir || use_ls_remote ||
+	    !string_format(path, "%s/HEAD", git_dir) ||
+	    !add_ref_stat(&stats, &size, path, &racy) ||
+	    !string_format(path, "%s/packed-refs", git_dir) ||
+	    !add_ref_stat(&stats, &size, path, &racy) ||
+	    !string_format(path, "%s/refs", git_dir) ||
+	    !add_ref_dir_stats(&stats, &size, path, strlen(path), &racy)) {
+		free(stats);
+		refs_stat_valid = FALSE;
+		return TRUE;
+	}
+
+	if (refs_stat_valid && size == refs_stat_size &&
+	    !memcmp(stats, refs_stat, size * sizeof(*stats)))
+		changed = FALSE;
+
+	free(refs_stat);
+	refs_stat = stats;
+	refs_stat_size = size;
+	refs_stat_valid = !racy;
+	return changed;
+}
+
 static int
-reload_refs(const char *git_dir, const char *remote_name, char *head, size_t headlen)
+reload_refs(const char *git_dir, const char *remote_name, char *head, size_t headlen, bool use_ls_remote)
 {
 	const char *head_argv[] = {
 		"git", "symbolic-ref", "HEAD", NULL
@@ -238,8 +833,10 @@ reload_refs(const char *git_dir, const char *remote_name, char *head, size_t hea
 	if (!*git_dir)
 		return OK;
 
-	if (!*head && io_run_buf(head_argv, head, headlen) &&
-	    !prefixcmp(head, "refs/heads/")) {
+	if (!*head && !read_head_ref(git_dir, head, headlen))
+		io_run_buf(head_argv, head, headlen);
+
+	if (!prefixcmp(head, "refs/heads/")) {
 		char *offset = head + STRING_SIZE("refs/heads/");
 
 		memmove(head, offset, strlen(offset) + 1);
@@ -251,14 +848,24 @@ reload_refs(const char *git_dir, const char *remote_name, char *head, size_t hea
 
 	done_ref_lists();
 
-	if (io_run_load(ls_remote_argv, "\t", read_ref, &opt) == ERR)
+	if ((use_ls_remote || read_refs_from_files(git_dir, &opt) == ERR) &&
+	    io_run_load(ls_remote_argv, "\t", read_ref, &opt) == ERR)
 		return ERR;
 
-	for (i = 0; i < refs_size; i++)
-		if (!refs[i]->valid)
-			refs[i]->id[0] = 0;
+	for (i = 0; i < refs_size; i++) {
+		struct ref *ref = refs[i];
 
-	qsort(refs, refs_size, sizeof(*refs), compare_refs);
+		if (ref->valid)
+			continue;
+		if (ref->replace && ref->id[0])
+			htab_remove_elt_with_hash(refs_by_replaced_id, ref->id, htab_hash_string(ref->id));
+		ref->id[0] = 0;
+	}
+
+	if (!init_ref_lists()) {
+		done_ref_lists();
+		return ERR;
+	}
 
 	return OK;
 }
@@ -267,14 +874,24 @@ int
 load_refs(bool force)
 {
 	static bool loaded = FALSE;
+	bool use_ls_remote = !!getenv("TIG_LS_REMOTE");
+
+	if (!force && loaded)
+		return OK;
+
+	if (!update_refs_stat(repo.git_dir, use_ls_remote) && loaded)
+		return OK;
 
 	if (force)
 		repo.head[0] = 0;
-	else if (loaded)
-		return OK;
 
 	loaded = TRUE;
-	return reload_refs(repo.git_dir, repo.remote, repo.head, sizeof(repo.head));
+	if (reload_refs(repo.git_dir, repo.remote, repo.head, sizeof(repo.head), use_ls_remote) == ERR) {
+		refs_stat_valid = FALSE;
+		return ERR;
+	}
+
+	return OK;
 }
 
 int
@@ -282,6 +899,7 @@ add_ref(const char *id, char *name, const char *remote_name, const char *head)
 {
 	struct ref_opt opt = { remote_name, head };
 
+	done_ref_lists();
 	return add_to_refs(id, strlen(id), name, strlen(name), &opt);
 }
 
@@ -163,12 +163,15 @@ stage_update(struct view *view, struct line *line, bool single)
 
 	} else if (!stage_status.status) {
 		view = view->parent;
+		if (!complete_update(view))
+			return FALSE;
 
 		for (line = view->line; view_has_line(view, line); line++)
 			if (line->type == stage_line_type)
 				break;
 
-		if (!status_update_files(view, line + 1)) {
+		if (!status_update_files(view, line + 1) ||
+		    !status_update_finish()) {
 			report("Failed to update files");
 			return FALSE;
 		}
@@ -252,11 +255,10 @@ stage_insert_chunk(struct view *view, struct chunk_header *header,
 			header->new.position, header->new.lines))
 		return NULL;
 
-	chunk_line = strdup(buf);
+	chunk_line = arena_strndup(&view->arena, buf, strlen(buf));
 	if (!chunk_line)
 		return NULL;
 
-	free(from->data);
 	from->data = chunk_line;
 
 	if (!to)
@@ -441,7 +443,8 @@ stage_request(struct view *view, enum request request, struct line *line)
 
 	/* Check whether the staged entry still exists, and close the
 	 * stage view if it doesn't. */
-	if (!status_exists(view->parent, &stage_status, stage_line_type)) {
+	if (!complete_update(view->parent) ||
+	    !status_exists(view->parent, &stage_status, stage_line_type)) {
 		status_restore(view->parent);
 		return REQ_VIEW_CLOSE;
 	}
@@ -518,6 +521,7 @@ stage_open(struct view *view, enum open_flags flags)
 
 	view->vid[0] = 0;
 	view->dir = repo.cdup;
+	watch_register(&view->watch, WATCH_HEAD | WATCH_INDEX);
 	return begin_update(view, NULL, NULL, flags);
 }
 
@@ -539,7 +543,7 @@ struct view_ops stage_ops = {
 	"line",
 	{ "stage" },
 	argv_env.status,
-	VIEW_DIFF_LIKE | VIEW_REFRESH,
+	VIEW_DIFF_LIKE | VIEW_REFRESH | VIEW_KEEP_TEXT,
 	sizeof(struct stage_state),
 	stage_open,
 	stage_read,
@@ -22,6 +22,7 @@ stash_open(struct view *view, enum open_flags flags)
 
 	state->added_changes_commits = TRUE;
 	state->with_graph = FALSE;
+	watch_register(&view->watch, WATCH_REFS);
 	return begin_update(view, NULL, stash_argv, flags | OPEN_RELOAD);
 }
 
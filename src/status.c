@@ -11,6 +11,7 @@
  * GNU General Public License for more details.
  */
 
+#include "tig/argv.h"
 #include "tig/io.h"
 #include "tig/refs.h"
 #include "tig/repo.h"
@@ -21,6 +22,8 @@
 #include "tig/draw.h"
 #include "tig/git.h"
 #include "tig/status.h"
+#include "tig/watch.h"
+#include "compat/hashtab.h"
 
 /*
  * Status backend
@@ -70,97 +73,374 @@ status_get_diff(struct status *file, const char *buf, size_t bufsize)
 	return TRUE;
 }
 
+static const char *status_diff_index_argv[] = { GIT_DIFF_STAGED_FILES("-z") };
+static const char *status_diff_files_argv[] = { GIT_DIFF_UNSTAGED_FILES("-z") };
+
+static const char *status_list_other_argv[] = {
+	"git", "ls-files", "-z", "--others", "--exclude-standard", repo.prefix, NULL, NULL,
+};
+
+static const char *status_list_no_head_argv[] = {
+	"git", "ls-files", "-z", "--cached", "--exclude-standard", NULL
+};
+
+const char *update_index_argv[] = {
+	"git", "update-index", "-q", "--unmerged", "--refresh", NULL
+};
+
+/* Commands for loading only some paths, which are appended. The index is
+ * refreshed for the paths using git-status(1), since git-update-index(1)
+ * fails for paths not in the index. */
+static const char *status_refresh_paths_argv[] = {
+	"git", "--literal-pathspecs", "status", "--porcelain", "-z", "--untracked-files=no", NULL
+};
+
+static const char *status_diff_files_paths_argv[] = {
+	"git", "--literal-pathspecs", "diff-files", "-z", NULL
+};
+
+static const char *status_list_other_paths_argv[] = {
+	"git", "--literal-pathspecs", "ls-files", "-z", "--others", "--exclude-standard", NULL
+};
+
+/* Files of a section which do not all have to be loaded again when the
+ * view is reloaded, because the section is not affected by updating files
+ * in another section or the paths changed in the working tree are known.
+ * The files are restored and only the changed paths are loaded. */
+struct status_section {
+	enum line_type type;
+	struct status *files;
+	size_t size;
+	const char **paths;		/* Changed paths, NULL if unknown. */
+};
+
+/* Sections of unstaged and untracked files. */
+static struct status_section status_saved_sections[2];
+
+/* Trailing checksum of the index, which changes whenever it is written. */
+struct status_index {
+	off_t size;
+	unsigned char checksum[20];
+};
+
+/* Whether the view is up to date with the index and the working tree as
+ * of the last reset of the working tree watcher. */
+static bool status_loaded;
+static struct status_index status_loaded_index;
+
+/* The status view is loaded from several sources, which are all started
+ * up front and then read one after the other. Unstaged files are listed
+ * only after the index has been refreshed, since files with stale index
+ * stat information would otherwise show up as modified. */
+enum status_source {
+	STATUS_SOURCE_STAGED,
+	STATUS_SOURCE_REFRESH,
+	STATUS_SOURCE_UNSTAGED,
+	STATUS_SOURCE_UNTRACKED,
+};
+
+struct status_state {
+	struct io refresh;		/* Index refresh, read after staged files. */
+	struct io unstaged;
+	struct io untracked;
+	enum status_source source;	/* Source being read by the view. */
+	enum line_type type;		/* Section being loaded. */
+	char status;			/* Status of all files in the section. */
+	struct status *file;		/* File waiting for its name. */
+	struct status *unmerged;	/* Unmerged file waiting for its diff. */
+	struct position position;	/* Position to restore once loaded. */
+	struct status_section saved[2];	/* Sections to restore instead of loading. */
+	size_t merged;			/* Header of section to sort once loaded. */
+	bool stale;			/* Files were restored without checking. */
+};
+
+static struct status_section *
+status_get_section(struct status_section sections[2], enum line_type type)
+{
+	return &sections[type == LINE_STAT_UNTRACKED];
+}
+
+static void
+status_free_section(struct status_section *section)
+{
+	free(section->files);
+	argv_free(section->paths);
+	free(section->paths);
+	memset(section, 0, sizeof(*section));
+}
+
 static bool
-status_run(struct view *view, const char *argv[], char status, enum line_type type)
+status_read_index(struct status_index *index)
 {
-	struct status *unmerged = NULL;
-	char *buf;
-	struct io io;
+	char path[SIZEOF_STR];
+	struct stat st;
+	bool ok;
+	int fd;
+
+	memset(index, 0, sizeof(*index));
+	if (!string_format(path, "%s/index", repo.git_dir) ||
+	    (fd = open(path, O_RDONLY)) == -1)
+		return FALSE;
+
+	ok = !fstat(fd, &st) && st.st_size >= sizeof(index->checksum) &&
+	     pread(fd, index->checksum, sizeof(index->checksum),
+		   st.st_size - sizeof(index->checksum)) == sizeof(index->checksum);
+	index->size = ok ? st.st_size : 0;
+	close(fd);
+	return ok;
+}
+
+/* Get the paths changed in the working tree since the view was loaded. */
+static const char **
+status_get_changes(void)
+{
+	return status_loaded ? watch_worktree_changes() : NULL;
+}
+
+static void
+status_kill_sources(struct view *view, struct status_state *state)
+{
+	struct io *sources[] = { &state->refresh, &state->unstaged, &state->untracked };
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sources); i++) {
+		if (sources[i] == view->pipe || !sources[i]->pid)
+			continue;
+		io_kill(sources[i]);
+		io_done(sources[i]);
+	}
+
+	for (i = 0; i < ARRAY_SIZE(state->saved); i++)
+		status_free_section(&state->saved[i]);
+}
+
+static bool
+status_is_loading_section(struct status_section *saved, enum line_type type)
+{
+	return !saved || saved->type != type || (saved->paths && *saved->paths);
+}
 
-	if (!io_run(&io, IO_RD, repo.cdup, opt_env, argv))
+/* Start loading a section of files either completely or only changed
+ * paths of a saved section. */
+static bool
+status_run_section(struct io *io, struct status_section *saved, enum line_type type,
+		   const char *argv[], const char *paths_argv[])
+{
+	const char **paths_argv_copy = NULL;
+	bool ok;
+
+	if (saved->type != type)
+		return io_run(io, IO_RD, repo.cdup, opt_env, argv);
+	if (!status_is_loading_section(saved, type))
+		return TRUE;
+
+	ok = argv_append_array(&paths_argv_copy, paths_argv) &&
+	     argv_append(&paths_argv_copy, "--") &&
+	     argv_append_array(&paths_argv_copy, saved->paths) &&
+	     io_run(io, IO_RD, repo.cdup, opt_env, paths_argv_copy);
+	argv_free(paths_argv_copy);
+	free(paths_argv_copy);
+	return ok;
+}
+
+static void
+status_end_section(struct view *view)
+{
+	if (!view->line[view->lines - 1].data)
+		add_line_nodata(view, LINE_STAT_NONE);
+}
+
+/* Start a section, which is read from the given source unless all its
+ * files are restored from the saved section. */
+static bool
+status_start_section(struct view *view, struct status_state *state, struct io *io,
+		     struct status_section *saved, enum line_type type, char status)
+{
+	bool loading = status_is_loading_section(saved, type);
+	size_t i;
+
+	if (loading) {
+		if (view->pipe != io)
+			io_done(view->pipe);
+		view->pipe = io;
+	}
+	state->type = type;
+	state->status = status;
+	state->file = state->unmerged = NULL;
+	if (!add_line_nodata(view, type))
 		return FALSE;
 
-	add_line_nodata(view, type);
+	if (saved && saved->type == type) {
+		size_t header = view->lines - 1;
+
+		for (i = 0; i < saved->size; i++)
+			if (!add_line(view, &saved->files[i], type, sizeof(*saved->files), FALSE))
+				return FALSE;
+		if (!saved->paths)
+			state->stale = TRUE;
+		state->merged = loading && saved->size ? header : 0;
+		status_free_section(saved);
+	}
+
+	if (!loading)
+		status_end_section(view);
+	return TRUE;
+}
+
+static int
+status_compare_line(const void *l1, const void *l2)
+{
+	const struct status *status1 = ((const struct line *) l1)->data;
+	const struct status *status2 = ((const struct line *) l2)->data;
+
+	return strcmp(status1->new.name, status2->new.name);
+}
+
+/* Merge the loaded files with the restored files of a section. */
+static void
+status_sort_section(struct view *view, size_t header)
+{
+	size_t i;
+
+	qsort(view->line + header + 1, view->lines - header - 1,
+	      sizeof(*view->line), status_compare_line);
+	for (i = header + 1; i < view->lines; i++) {
+		view->line[i].lineno = i + 1;
+		view->line[i].dirty = 1;
+	}
+}
+
+/* Switch to the next source when the current one has been read. Saved
+ * sections are restored and only changed paths are loaded. */
+static bool
+status_read_done(struct view *view, struct status_state *state)
+{
+	struct status_section *saved;
+
+	/* Loading was aborted or failed. */
+	if (!io_eof(view->pipe)) {
+		status_kill_sources(view, state);
+		return TRUE;
+	}
 
-	while ((buf = io_get(&io, 0, TRUE))) {
-		struct status *file = unmerged;
+	if (state->source != STATUS_SOURCE_REFRESH) {
+		if (state->merged)
+			status_sort_section(view, state->merged);
+		status_end_section(view);
+	}
+	state->merged = 0;
+
+	while (state->source++ < STATUS_SOURCE_UNTRACKED) {
+		switch (state->source) {
+		case STATUS_SOURCE_REFRESH:
+			saved = status_get_section(state->saved, LINE_STAT_UNSTAGED);
+			if (!status_is_loading_section(saved, LINE_STAT_UNSTAGED))
+				continue;
+			io_done(view->pipe);
+			view->pipe = &state->refresh;
+			return FALSE;
 
-		if (!file) {
-			if (!add_line_alloc(view, &file, type, 0, FALSE))
-				goto error_out;
+		case STATUS_SOURCE_UNSTAGED:
+			/* Remember the index the files are compared against. */
+			status_read_index(&status_loaded_index);
+			saved = status_get_section(state->saved, LINE_STAT_UNSTAGED);
+			if (!status_run_section(&state->unstaged, saved, LINE_STAT_UNSTAGED,
+						status_diff_files_argv, status_diff_files_paths_argv) ||
+			    !status_start_section(view, state, &state->unstaged, saved, LINE_STAT_UNSTAGED, 0))
+				break;
+			if (view->pipe != &state->unstaged)
+				continue;
+			return FALSE;
+
+		case STATUS_SOURCE_UNTRACKED:
+		default:
+			saved = status_get_section(state->saved, LINE_STAT_UNTRACKED);
+			if (!status_start_section(view, state, &state->untracked, saved, LINE_STAT_UNTRACKED, '?'))
+				break;
+			if (view->pipe != &state->untracked)
+				continue;
+			return FALSE;
 		}
 
+		report("Failed to load status data");
+		status_kill_sources(view, state);
+		return TRUE;
+	}
+
+	status_loaded = !state->stale && status_loaded_index.size;
+
+	/* Restore the exact position or use the specialized restore
+	 * mode? Unless the position was changed while loading. */
+	if (!check_position(&view->pos)) {
+		view->prev_pos = state->position;
+		status_restore(view);
+		view->force_redraw = TRUE;
+	}
+	return TRUE;
+}
+
+/* Parse the NUL separated output of git-diff-index(1), git-diff-files(1)
+ * and git-ls-files(1), where each file is described by a diff info part
+ * (unless all files have the same status) followed by one or two names. */
+static bool
+status_read(struct view *view, char *buf)
+{
+	struct status_state *state = view->private;
+	struct status *file = state->file;
+
+	if (!buf)
+		return status_read_done(view, state);
+
+	if (state->source == STATUS_SOURCE_REFRESH)
+		return TRUE;
+
+	if (!file) {
+		file = state->unmerged;
+		if (!file && !add_line_alloc(view, &file, state->type, 0, FALSE))
+			return FALSE;
+
 		/* Parse diff info part. */
-		if (status) {
-			file->status = status;
-			if (status == 'A')
+		if (state->status) {
+			file->status = state->status;
+			if (state->status == 'A')
 				string_copy(file->old.rev, NULL_ID);
 
-		} else if (!file->status || file == unmerged) {
+		} else {
 			if (!status_get_diff(file, buf, strlen(buf)))
-				goto error_out;
-
-			buf = io_get(&io, 0, TRUE);
-			if (!buf)
-				break;
+				return FALSE;
 
 			/* Collapse all modified entries that follow an
 			 * associated unmerged entry. */
-			if (unmerged == file) {
-				unmerged->status = 'U';
-				unmerged = NULL;
+			if (state->unmerged == file) {
+				state->unmerged->status = 'U';
+				state->unmerged = NULL;
 			} else if (file->status == 'U') {
-				unmerged = file;
+				state->unmerged = file;
 			}
-		}
-
-		/* Grab the old name for rename/copy. */
-		if (!*file->old.name &&
-		    (file->status == 'R' || file->status == 'C')) {
-			string_ncopy(file->old.name, buf, strlen(buf));
 
-			buf = io_get(&io, 0, TRUE);
-			if (!buf)
-				break;
+			state->file = file;
+			return TRUE;
 		}
-
-		/* git-ls-files just delivers a NUL separated list of
-		 * file names similar to the second half of the
-		 * git-diff-* output. */
-		string_ncopy(file->new.name, buf, strlen(buf));
-		if (!*file->old.name)
-			string_copy(file->old.name, file->new.name);
-		file = NULL;
 	}
 
-	if (io_error(&io)) {
-error_out:
-		io_done(&io);
-		return FALSE;
+	/* Grab the old name for rename/copy. */
+	if (!*file->old.name &&
+	    (file->status == 'R' || file->status == 'C')) {
+		string_ncopy(file->old.name, buf, strlen(buf));
+		state->file = file;
+		return TRUE;
 	}
 
-	if (!view->line[view->lines - 1].data)
-		add_line_nodata(view, LINE_STAT_NONE);
-
-	io_done(&io);
+	/* git-ls-files just delivers a NUL separated list of
+	 * file names similar to the second half of the
+	 * git-diff-* output. */
+	string_ncopy(file->new.name, buf, strlen(buf));
+	if (!*file->old.name)
+		string_copy(file->old.name, file->new.name);
+	state->file = NULL;
 	return TRUE;
 }
 
-static const char *status_diff_index_argv[] = { GIT_DIFF_STAGED_FILES("-z") };
-static const char *status_diff_files_argv[] = { GIT_DIFF_UNSTAGED_FILES("-z") };
-
-static const char *status_list_other_argv[] = {
-	"git", "ls-files", "-z", "--others", "--exclude-standard", repo.prefix, NULL, NULL,
-};
-
-static const char *status_list_no_head_argv[] = {
-	"git", "ls-files", "-z", "--cached", "--exclude-standard", NULL
-};
-
-const char *update_index_argv[] = {
-	"git", "update-index", "-q", "--unmerged", "--refresh", NULL
-};
-
 /* Restore the previous line number to stay in the context or select a
  * line with something that can be updated. */
 void
@@ -244,36 +524,53 @@ status_update_onbranch(void)
 static bool
 status_open(struct view *view, enum open_flags flags)
 {
+	struct status_state *state = view->private;
 	const char **staged_argv = is_initial_commit() ?
 		status_list_no_head_argv : status_diff_index_argv;
 	char staged_status = staged_argv == status_list_no_head_argv ? 'A' : 0;
 
+	struct status_section *unstaged = status_get_section(state->saved, LINE_STAT_UNSTAGED);
+	struct status_section *untracked = status_get_section(state->saved, LINE_STAT_UNTRACKED);
+
+	memcpy(state->saved, status_saved_sections, sizeof(state->saved));
+	memset(status_saved_sections, 0, sizeof(status_saved_sections));
+
 	if (repo.is_inside_work_tree == FALSE) {
 		report("The status view requires a working tree");
+		status_kill_sources(view, state);
 		return FALSE;
 	}
 
-	reset_view(view);
-
-	add_line_nodata(view, LINE_STAT_HEAD);
-	status_update_onbranch();
-
-	io_run_bg(update_index_argv);
-
 	status_list_other_argv[ARRAY_SIZE(status_list_other_argv) - 2] =
 		opt_status_untracked_dirs ? NULL : "--directory";
 
-	if (!status_run(view, staged_argv, staged_status, LINE_STAT_STAGED) ||
-	    !status_run(view, status_diff_files_argv, 0, LINE_STAT_UNSTAGED) ||
-	    !status_run(view, status_list_other_argv, '?', LINE_STAT_UNTRACKED)) {
+	watch_register(&view->watch, WATCH_HEAD | WATCH_INDEX);
+
+	/* Changes made from now on are loaded on the next refresh. */
+	status_loaded = FALSE;
+	if (opt_status_watch && watch_worktree(repo.cdup))
+		watch_worktree_reset();
+	else if (!opt_status_watch)
+		watch_worktree_stop();
+
+	if (!begin_update(view, repo.cdup, staged_argv, OPEN_RELOAD) ||
+	    !status_run_section(&state->refresh, unstaged, LINE_STAT_UNSTAGED,
+				update_index_argv, status_refresh_paths_argv) ||
+	    !status_run_section(&state->untracked, untracked, LINE_STAT_UNTRACKED,
+				status_list_other_argv, status_list_other_paths_argv)) {
 		report("Failed to load status data");
+		status_kill_sources(view, state);
 		return FALSE;
 	}
 
-	/* Restore the exact position or use the specialized restore
-	 * mode? */
-	status_restore(view);
-	return TRUE;
+	/* Restore the position once all sections have been loaded. */
+	state->position = view->prev_pos;
+	clear_position(&view->prev_pos);
+
+	add_line_nodata(view, LINE_STAT_HEAD);
+	status_update_onbranch();
+
+	return status_start_section(view, state, view->pipe, NULL, LINE_STAT_STAGED, staged_status);
 }
 
 static bool
@@ -425,16 +722,17 @@ status_update_prepare(struct io *io, enum line_type type)
 }
 
 static bool
-status_update_write(struct io *io, struct status *status, enum line_type type)
+status_update_format(char *buf, size_t bufsize, size_t *bufpos,
+		     struct status *status, enum line_type type)
 {
 	switch (type) {
 	case LINE_STAT_STAGED:
-		return io_printf(io, "%06o %s\t%s%c", status->old.mode,
-				 status->old.rev, status->old.name, 0);
+		return string_nformat(buf, bufsize, bufpos, "%06o %s\t%s%c", status->old.mode,
+				      status->old.rev, status->old.name, 0);
 
 	case LINE_STAT_UNSTAGED:
 	case LINE_STAT_UNTRACKED:
-		return io_printf(io, "%s%c", status->new.name, 0);
+		return string_nformat(buf, bufsize, bufpos, "%s%c", status->new.name, 0);
 
 	default:
 		die("line type %d not handled in switch", type);
@@ -442,6 +740,19 @@ status_update_write(struct io *io, struct status *status, enum line_type type)
 	}
 }
 
+/* Room needed for formatting the update of a single file. */
+#define SIZEOF_STATUS_UPDATE	(SIZEOF_STR + 64)
+
+static bool
+status_update_write(struct io *io, struct status *status, enum line_type type)
+{
+	char buf[SIZEOF_STATUS_UPDATE];
+	size_t bufpos = 0;
+
+	return status_update_format(buf, sizeof(buf), &bufpos, status, type) &&
+	       io_write(io, buf, bufpos);
+}
+
 bool
 status_update_file(struct status *status, enum line_type type)
 {
@@ -455,43 +766,364 @@ status_update_file(struct status *status, enum line_type type)
 	return io_done(&io) && result;
 }
 
+/* Get the section which is not affected by updating the given line, so
+ * it can be restored instead of reloaded. */
+static enum line_type
+status_unaffected_section(struct view *view, struct line *line)
+{
+	struct line *pos;
+
+	switch (line->type) {
+	case LINE_STAT_UNSTAGED:
+		return LINE_STAT_UNTRACKED;
+
+	case LINE_STAT_UNTRACKED:
+		return LINE_STAT_UNSTAGED;
+
+	case LINE_STAT_STAGED:
+		/* Unstaging added files makes them untracked. */
+		for (pos = line->data ? line : line + 1; view_has_line(view, pos) && pos->data; pos++) {
+			struct status *status = pos->data;
+
+			if (strchr("ACR", status->status))
+				return LINE_STAT_NONE;
+			if (line->data)
+				break;
+		}
+		return LINE_STAT_UNTRACKED;
+
+	default:
+		return LINE_STAT_NONE;
+	}
+}
+
+static int
+status_path_eq(const void *entry, const void *element)
+{
+	return !strcmp(entry, element);
+}
+
+static bool
+status_add_path(htab_t paths, const char ***argv, const char *path)
+{
+	hashval_t hash = htab_hash_string(path);
+	void **slot;
+
+	if (htab_find_with_hash(paths, path, hash))
+		return TRUE;
+	slot = htab_find_slot_with_hash(paths, path, hash, INSERT);
+	if (!slot || !argv_append(argv, path))
+		return FALSE;
+	*slot = (void *) (*argv)[argv_size(*argv) - 1];
+	return TRUE;
+}
+
+/* Get the changed paths to load for a section. Untracked files are only
+ * listed below the prefix and changed ignore rules may affect any of
+ * them. */
+static bool
+status_get_section_paths(enum line_type type, const char **changes,
+			 htab_t paths, const char ***argv)
+{
+	char prefix[SIZEOF_STR];
+	size_t prefixlen = strlen(repo.prefix);
+	int i;
+
+	string_ncopy(prefix, repo.prefix, prefixlen);
+	if (prefixlen && prefix[prefixlen - 1] == '/')
+		prefix[--prefixlen] = 0;
+
+	for (i = 0; changes[i]; i++) {
+		const char *path = changes[i];
+		const char *name = strrchr(path, '/');
+		size_t pathlen = strlen(path);
+
+		if (type == LINE_STAT_UNTRACKED) {
+			if (!strcmp(name ? name + 1 : path, ".gitignore"))
+				return FALSE;
+
+			if (pathlen < prefixlen && !strncmp(prefix, path, pathlen) &&
+			    prefix[pathlen] == '/')
+				path = prefix;
+			else if (prefixlen && (strncmp(prefix, path, prefixlen) ||
+					       (path[prefixlen] && path[prefixlen] != '/')))
+				continue;
+		}
+
+		if (!status_add_path(paths, argv, path))
+			return FALSE;
+	}
+
+	if (!*argv)
+		*argv = calloc(1, sizeof(**argv));
+	return *argv != NULL;
+}
+
+/* Check whether the file is one of the paths or below one of them. */
+static bool
+status_has_changed(htab_t paths, const char *name)
+{
+	char path[SIZEOF_STR];
+	size_t i;
+
+	string_ncopy(path, name, strlen(name));
+	for (i = 0; path[i]; i++) {
+		if (path[i] == '/') {
+			path[i] = 0;
+			if (htab_find(paths, path))
+				return TRUE;
+			path[i] = '/';
+		}
+	}
+
+	return htab_find(paths, path) != NULL;
+}
+
+/* Save the files of a section to restore them when reloading. Files of
+ * changed paths are left out to be loaded again. Returns whether the
+ * changed paths for the section are known. */
+static bool
+status_save_section(struct view *view, enum line_type type, const char **changes)
+{
+	struct status_section *saved = status_get_section(status_saved_sections, type);
+	struct line *header = find_next_line_by_type(view, view->line, type);
+	htab_t paths = NULL;
+	struct line *line;
+	size_t size = 0;
+
+	status_free_section(saved);
+	if (type == LINE_STAT_NONE || !header)
+		return FALSE;
+
+	/* Files in collapsed untracked directories cannot be reloaded. */
+	if (changes && (type != LINE_STAT_UNTRACKED || opt_status_untracked_dirs)) {
+		paths = htab_create_alloc(64, htab_hash_string, status_path_eq, NULL, calloc, free);
+		if (paths && !status_get_section_paths(type, changes, paths, &saved->paths)) {
+			argv_free(saved->paths);
+			free(saved->paths);
+			saved->paths = NULL;
+		}
+	}
+
+	for (line = header + 1; view_has_line(view, line) && line->data; line++)
+		size++;
+
+	saved->files = size ? calloc(size, sizeof(*saved->files)) : NULL;
+	if (size && !saved->files) {
+		status_free_section(saved);
+		if (paths)
+			htab_delete(paths);
+		return FALSE;
+	}
+
+	for (line = header + 1; view_has_line(view, line) && line->data; line++) {
+		struct status *status = line->data;
+
+		if (!saved->paths || !status_has_changed(paths, status->new.name))
+			saved->files[saved->size++] = *status;
+	}
+	saved->type = type;
+
+	if (paths)
+		htab_delete(paths);
+	return saved->paths != NULL;
+}
+
+/* Reload only the paths changed in the working tree if they are known and
+ * the index has not been written by anyone else. */
+static void
+status_save_changes(struct view *view)
+{
+	const char **changes = status_get_changes();
+	struct status_index index;
+
+	if (!changes || !status_read_index(&index) ||
+	    memcmp(&index, &status_loaded_index, sizeof(index)))
+		return;
+
+	if (!status_save_section(view, LINE_STAT_UNSTAGED, changes))
+		status_free_section(status_get_section(status_saved_sections, LINE_STAT_UNSTAGED));
+	else if (!status_save_section(view, LINE_STAT_UNTRACKED, changes))
+		status_free_section(status_get_section(status_saved_sections, LINE_STAT_UNTRACKED));
+}
+
+/* Updating all files of a section is written to git-update-index(1)
+ * from the main loop, so the view stays responsive while the files are
+ * updated. Ctrl-C stops writing and closes the input of
+ * git-update-index(1). */
+struct status_update {
+	struct io io;
+	struct view *view;		/* View to reload once done, if any. */
+	enum line_type unaffected;	/* Section to restore when reloading. */
+	char *buf;			/* Input for git-update-index(1). */
+	size_t size;
+	size_t written;
+	int files;
+	int files_written;
+	int done;			/* Percentage last reported. */
+	struct timeval start;
+	void (*sigint)(int);
+};
+
+DEFINE_ALLOCATOR(realloc_status_update_buf, char, BUFSIZ)
+
+static struct status_update status_updating;
+static volatile sig_atomic_t status_update_interrupted;
+
+static void
+status_update_interrupt(int sig)
+{
+	status_update_interrupted = 1;
+}
+
+static void
+status_update_progress(struct status_update *update)
+{
+	int done = update->files_written * 100 / update->files;
+	struct timeval now;
+	unsigned long msecs;
+
+	if (done <= update->done || !update->view)
+		return;
+
+	gettimeofday(&now, NULL);
+	msecs = (now.tv_sec - update->start.tv_sec) * 1000 + (now.tv_usec - update->start.tv_usec) / 1000;
+	update->done = done;
+	string_format(update->view->ref, "updating file %u of %u (%d%% done, %lu files/s)",
+		      update->files_written, update->files, done,
+		      msecs ? update->files_written * 1000UL / msecs : 0);
+	update_view_title(update->view);
+}
+
+/* Wait for git-update-index(1) and reload the view, which started the
+ * update. Sections not affected by the update are restored from their
+ * current files. */
+static bool
+status_update_end(struct status_update *update, bool ok)
+{
+	struct view *view = update->view;
+	enum line_type unaffected = update->unaffected;
+	bool interrupted = status_update_interrupted;
+
+	/* git-update-index(1) has most likely been interrupted as well. */
+	ok = io_done(&update->io) && ok;
+	if (interrupted)
+		ok = TRUE;
+	signal(SIGINT, update->sigint);
+	free(update->buf);
+	memset(update, 0, sizeof(*update));
+	status_update_interrupted = 0;
+
+	if (view) {
+		if (!view->pipe)
+			status_save_section(view, unaffected, status_get_changes());
+		refresh_view(view);
+
+		if (interrupted)
+			report("Updating files was interrupted");
+		else if (!ok)
+			report("Failed to update file status");
+	}
+
+	return ok;
+}
+
+/* Write the input which git-update-index(1) accepts without blocking
+ * and finish the update once everything has been written. */
+void
+status_update_continue(void)
+{
+	struct status_update *update = &status_updating;
+	ssize_t size = 0;
+
+	if (!update->io.pid)
+		return;
+
+	while (!status_update_interrupted && update->written < update->size) {
+		const char *pos = update->buf + update->written;
+
+		size = io_write_some(&update->io, pos, update->size - update->written);
+		if (size <= 0)
+			break;
+
+		update->written += size;
+		for (; (pos = memchr(pos, 0, size)); pos++, size = update->buf + update->written - pos)
+			update->files_written++;
+	}
+
+	if (status_update_interrupted || update->written == update->size || size < 0) {
+		status_update_end(update, size >= 0);
+		return;
+	}
+
+	status_update_progress(update);
+}
+
+/* Get the descriptor to poll before calling status_update_continue().
+ * Returns FALSE if no files are being updated. */
+bool
+status_update_wait(int *fd)
+{
+	if (!status_updating.io.pid)
+		return FALSE;
+	*fd = status_updating.io.pipe;
+	return TRUE;
+}
+
+/* Write the remaining input without returning to the main loop. */
+bool
+status_update_finish(void)
+{
+	struct status_update *update = &status_updating;
+	bool ok;
+
+	if (!update->io.pid)
+		return TRUE;
+
+	update->view = NULL;
+	ok = status_update_interrupted ||
+	     io_write(&update->io, update->buf + update->written, update->size - update->written);
+	return status_update_end(update, ok);
+}
+
+/* Start updating the files of the section starting at the given line.
+ * The update is written from the main loop and the view is reloaded once
+ * it is done, unless status_update_finish() is called. */
 bool
 status_update_files(struct view *view, struct line *line)
 {
-	char buf[sizeof(view->ref)];
-	struct io io;
-	bool result = TRUE;
+	struct status_update *update = &status_updating;
 	struct line *pos;
-	int files = 0;
-	int file, done;
-	int cursor_y = -1, cursor_x = -1;
 
-	if (!status_update_prepare(&io, line->type))
+	if (update->io.pid)
 		return FALSE;
 
-	for (pos = line; view_has_line(view, pos) && pos->data; pos++)
-		files++;
-
-	string_copy(buf, view->ref);
-	getsyx(cursor_y, cursor_x);
-	for (file = 0, done = 5; result && file < files; line++, file++) {
-		int almost_done = file * 100 / files;
-
-		if (almost_done > done) {
-			done = almost_done;
-			string_format(view->ref, "updating file %u of %u (%d%% done)",
-				      file, files, done);
-			update_view_title(view);
-			setsyx(cursor_y, cursor_x);
-			doupdate();
-		}
-		result = status_update_write(&io, line->data, line->type);
+	for (pos = line; view_has_line(view, pos) && pos->data; pos++, update->files++) {
+		if (!realloc_status_update_buf(&update->buf, update->size, SIZEOF_STATUS_UPDATE) ||
+		    !status_update_format(update->buf, update->size + SIZEOF_STATUS_UPDATE,
+					  &update->size, pos->data, pos->type))
+			goto fail;
 	}
-	string_copy(view->ref, buf);
 
-	return io_done(&io) && result;
+	if (!status_update_prepare(&update->io, line->type))
+		goto fail;
+
+	update->view = view;
+	update->done = 5;
+	update->unaffected = status_unaffected_section(view, line - 1);
+	gettimeofday(&update->start, NULL);
+	status_update_interrupted = 0;
+	update->sigint = signal(SIGINT, status_update_interrupt);
+	return TRUE;
+
+fail:
+	free(update->buf);
+	memset(update, 0, sizeof(*update));
+	return FALSE;
 }
 
+/* Update the selected file or section, and reload the view. Sections not
+ * affected by the update are restored from their current files. */
 static bool
 status_update(struct view *view)
 {
@@ -505,16 +1137,21 @@ status_update(struct view *view)
 			return FALSE;
 		}
 
+		/* The view is reloaded once the files have been updated. */
 		if (!status_update_files(view, line + 1)) {
 			report("Failed to update file status");
 			return FALSE;
 		}
+		return TRUE;
 
 	} else if (!status_update_file(line->data, line->type)) {
 		report("Failed to update file status");
 		return FALSE;
 	}
 
+	status_save_section(view, status_unaffected_section(view, line), status_get_changes());
+	refresh_view(view);
+
 	return TRUE;
 }
 
@@ -576,11 +1213,18 @@ status_request(struct view *view, enum request request, struct line *line)
 {
 	struct status *status = line->data;
 
+	if (status_updating.io.pid &&
+	    (request == REQ_STATUS_UPDATE || request == REQ_STATUS_REVERT ||
+	     request == REQ_STATUS_MERGE || request == REQ_REFRESH)) {
+		report("Files are being updated, press Ctrl-C to interrupt");
+		return REQ_NONE;
+	}
+
 	switch (request) {
 	case REQ_STATUS_UPDATE:
-		if (!status_update(view))
-			return REQ_NONE;
-		break;
+		if (complete_update(view))
+			status_update(view);
+		return REQ_NONE;
 
 	case REQ_STATUS_REVERT:
 		if (!status_revert(status, line->type, status_has_none(view, line)))
@@ -624,6 +1268,7 @@ status_request(struct view *view, enum request request, struct line *line)
 	case REQ_REFRESH:
 		/* Load the current branch information and then the view. */
 		load_refs(TRUE);
+		status_save_changes(view);
 		break;
 
 	default:
@@ -738,10 +1383,10 @@ struct view_ops status_ops = {
 	"file",
 	{ "status" },
 	"status",
-	VIEW_CUSTOM_STATUS | VIEW_SEND_CHILD_ENTER | VIEW_STATUS_LIKE | VIEW_REFRESH,
-	0,
+	VIEW_CUSTOM_STATUS | VIEW_SEND_CHILD_ENTER | VIEW_STATUS_LIKE | VIEW_REFRESH | VIEW_NUL_SEPARATED,
+	sizeof(struct status_state),
 	status_open,
-	NULL,
+	status_read,
 	status_draw,
 	status_request,
 	status_grep,
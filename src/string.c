@@ -84,6 +84,48 @@ string_copy_rev_from_commit_line(char *dst, const char *src)
 	string_copy_rev(dst, src + STRING_SIZE("commit "));
 }
 
+static inline int
+hexval(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+bool
+string_rev_to_id(unsigned char *id, const char *rev)
+{
+	int i;
+
+	for (i = 0; i < SIZEOF_ID; i++) {
+		int hi = hexval(rev[i * 2]);
+		int lo = hi < 0 ? -1 : hexval(rev[i * 2 + 1]);
+
+		if (lo < 0)
+			return FALSE;
+		id[i] = (hi << 4) | lo;
+	}
+
+	return TRUE;
+}
+
+void
+string_id_to_rev(char *rev, const unsigned char *id)
+{
+	static const char hex[] = "0123456789abcdef";
+	int i;
+
+	for (i = 0; i < SIZEOF_ID; i++) {
+		rev[i * 2] = hex[id[i] >> 4];
+		rev[i * 2 + 1] = hex[id[i] & 0xf];
+	}
+	rev[SIZEOF_REV - 1] = 0;
+}
+
 size_t
 string_expanded_length(const char *src, size_t srclen, size_t tabsize, size_t max_size)
 {
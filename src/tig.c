@@ -31,6 +31,7 @@
 #include "tig/draw.h"
 #include "tig/display.h"
 #include "tig/grep.h"
+#include "tig/status.h"
 
 static bool
 forward_request_to_child(struct view *child, enum request request)
@@ -213,7 +214,7 @@ open_run_request(struct view *view, enum request request)
 		else if (req->flags.exit)
 			request = REQ_QUIT;
 
-		else if (view_has_flags(view, VIEW_REFRESH) && !view->unrefreshable)
+		else if (view_can_refresh(view))
 			request = REQ_REFRESH;
 	}
 	return request;
@@ -785,6 +786,41 @@ handle_mouse_event(void)
 }
 #endif
 
+/* Refresh displayed views affected by repository changes. Returns the
+ * follow-up request of the current view. */
+static enum request
+refresh_changed_views(void)
+{
+	enum request request = REQ_NONE;
+	int i;
+
+	/* Child views are refreshed first since they may reload their
+	 * parent, e.g. the stage view reloads the status view. */
+	for (i = ARRAY_SIZE(display) - 1; i >= 0; i--) {
+		struct view *view = display[i];
+		enum request next;
+
+		if (!view || !watch_dirty(&view->watch) ||
+		    !view_can_refresh(view) || view->pipe)
+			continue;
+
+		view->watch.changed = WATCH_NONE;
+		next = view_request(view, REQ_REFRESH);
+		/* Empty views do not get requests, so reload them here. */
+		if (next == REQ_REFRESH)
+			refresh_view(view);
+		if (next == REQ_NONE || next == REQ_REFRESH)
+			continue;
+
+		if (i == current_view)
+			request = next;
+		else
+			view_driver(view, next);
+	}
+
+	return request;
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -847,6 +883,11 @@ main(int argc, const char *argv[])
 		}
 #endif
 
+		if (key == KEY_REPO_CHANGED) {
+			request = refresh_changed_views();
+			continue;
+		}
+
 		view = display[current_view];
 		request = get_keybinding(&view->ops->keymap, &input);
 
@@ -884,6 +925,7 @@ main(int argc, const char *argv[])
 		}
 	}
 
+	status_update_finish();
 	exit(EXIT_SUCCESS);
 
 	return 0;
@@ -19,6 +19,7 @@
 #include "tig/display.h"
 #include "tig/view.h"
 #include "tig/draw.h"
+#include "compat/hashtab.h"
 
 /* The top of the path stack. */
 static struct view_history tree_view_history = { sizeof(char *) };
@@ -81,7 +82,9 @@ struct tree_state {
 	const struct ident *author;
 	struct time author_time;
 	int size_width;
+	char tree_commit[SIZEOF_REV];	/* Commit of the tree, for caching. */
 	bool read_date;
+	size_t unannotated;	/* Number of entries without a date. */
 };
 
 static const char *
@@ -129,6 +132,31 @@ tree_compare(const void *l1, const void *l2)
 	}
 }
 
+static int
+tree_compare_line(const void *l1, const void *l2)
+{
+	return tree_compare_entry(l1, l2);
+}
+
+/* Entries are appended in the order listed by git-ls-tree(1) and sorted
+ * with directories first once all of them have been read. */
+static void
+tree_sort_entries(struct view *view)
+{
+	/* Skip "Directory ..." and ".." line. */
+	size_t first = 1 + !!*view->env->directory;
+	size_t i;
+
+	if (view->lines <= first + 1)
+		return;
+
+	qsort(view->line + first, view->lines - first, sizeof(*view->line), tree_compare_line);
+	for (i = first; i < view->lines; i++) {
+		view->line[i].lineno = i - first + 1;
+		view->line[i].dirty = view->line[i].cleareol = 1;
+	}
+	view->force_redraw = TRUE;
+}
 
 static struct line *
 tree_entry(struct view *view, enum line_type type, const char *path,
@@ -151,10 +179,225 @@ tree_entry(struct view *view, enum line_type type, const char *path,
 	return line;
 }
 
+/* Entries without a date, indexed by name while reading dates. */
+static htab_t tree_entries;
+
+static hashval_t
+tree_entry_hash(const void *line)
+{
+	return htab_hash_string(tree_path(line));
+}
+
+static int
+tree_entry_eq(const void *line, const void *name)
+{
+	return !strcmp(tree_path(line), name);
+}
+
+static bool
+tree_index_entries(struct view *view, struct tree_state *state)
+{
+	size_t i;
+
+	if (!tree_entries) {
+		tree_entries = htab_create_alloc(view->lines, tree_entry_hash, tree_entry_eq, NULL, calloc, free);
+		if (!tree_entries)
+			return FALSE;
+	} else {
+		htab_empty(tree_entries);
+	}
+
+	state->unannotated = 0;
+	for (i = 0; i < view->lines; i++) {
+		struct line *line = &view->line[i];
+		struct tree_entry *entry = line->data;
+		void **slot;
+
+		if (line->type == LINE_TREE_HEAD || entry->author ||
+		    tree_path_is_parent(entry->name))
+			continue;
+
+		slot = htab_find_slot_with_hash(tree_entries, entry->name,
+						htab_hash_string(entry->name), INSERT);
+		if (!slot)
+			return FALSE;
+		*slot = line;
+		state->unannotated++;
+	}
+
+	return TRUE;
+}
+
+/* Dates and authors of tree entries are kept for the whole session, keyed
+ * by the commit of the tree and the path of the entry. Entries one level
+ * below the directory being read are recorded too, so that subdirectories
+ * can reuse the history read for their parent. */
+struct tree_annotation {
+	const char *key;		/* "<commit> <path>" */
+	char commit[SIZEOF_REV];
+	const struct ident *author;
+	struct time time;
+};
+
+static htab_t tree_annotations;
+static htab_t tree_annotated_dirs;	/* Directories with all history read. */
+static struct arena tree_annotation_arena;
+
+static hashval_t
+tree_annotation_hash(const void *annotation)
+{
+	return htab_hash_string(((const struct tree_annotation *) annotation)->key);
+}
+
+static int
+tree_annotation_eq(const void *annotation, const void *key)
+{
+	return !strcmp(((const struct tree_annotation *) annotation)->key, key);
+}
+
+static int
+tree_annotated_dir_eq(const void *dir, const void *key)
+{
+	return !strcmp(dir, key);
+}
+
+static bool
+tree_init_annotations(void)
+{
+	if (!tree_annotations)
+		tree_annotations = htab_create_alloc(1024, tree_annotation_hash, tree_annotation_eq, NULL, calloc, free);
+	if (!tree_annotated_dirs)
+		tree_annotated_dirs = htab_create_alloc(16, htab_hash_string, tree_annotated_dir_eq, NULL, calloc, free);
+	return tree_annotations && tree_annotated_dirs;
+}
+
+/* Resolve the commit of the tree so cached dates are not reused when
+ * e.g. HEAD is moved. */
+static bool
+tree_resolve_commit(struct view *view, struct tree_state *state)
+{
+	const char *id = view->ops->id;
+	char spec[SIZEOF_STR];
+	const char *rev_parse_argv[] = {
+		"git", "rev-parse", "--verify", "--quiet", spec, NULL
+	};
+
+	if (strlen(id) == SIZEOF_REV - 1 && strspn(id, "0123456789abcdef") == SIZEOF_REV - 1) {
+		string_copy_rev(state->tree_commit, id);
+		return TRUE;
+	}
+
+	if (!string_format(spec, "%s^{commit}", id) ||
+	    !io_run_buf(rev_parse_argv, state->tree_commit, sizeof(state->tree_commit)))
+		state->tree_commit[0] = 0;
+
+	return !!*state->tree_commit;
+}
+
+static void
+tree_record_annotation(struct view *view, struct tree_state *state, const char *name, size_t namelen)
+{
+	struct tree_annotation *annotation;
+	char key[SIZEOF_STR];
+	hashval_t hash;
+	void **slot;
+
+	if (!string_format(key, "%s %s%.*s", state->tree_commit, view->env->directory, (int) namelen, name))
+		return;
+
+	hash = htab_hash_string(key);
+	if (htab_find_with_hash(tree_annotations, key, hash))
+		return;
+
+	annotation = arena_alloc(&tree_annotation_arena, sizeof(*annotation));
+	if (!annotation)
+		return;
+	annotation->key = arena_strndup(&tree_annotation_arena, key, strlen(key));
+	slot = annotation->key ? htab_find_slot_with_hash(tree_annotations, key, hash, INSERT) : NULL;
+	if (!slot)
+		return;
+
+	string_copy_rev(annotation->commit, state->commit);
+	annotation->author = state->author;
+	annotation->time = state->author_time;
+	*slot = annotation;
+}
+
+/* Annotate entries from the cache. Returns TRUE if the history of the
+ * directory still has to be read. */
+static bool
+tree_apply_annotations(struct view *view, struct tree_state *state)
+{
+	char key[SIZEOF_STR];
+	size_t i;
+
+	for (i = 0; i < view->lines; i++) {
+		struct line *line = &view->line[i];
+		struct tree_entry *entry = line->data;
+		struct tree_annotation *annotation;
+
+		if (line->type == LINE_TREE_HEAD || tree_path_is_parent(entry->name) ||
+		    !string_format(key, "%s %s%s", state->tree_commit, view->env->directory, entry->name))
+			continue;
+
+		annotation = htab_find_with_hash(tree_annotations, key, htab_hash_string(key));
+		if (!annotation)
+			continue;
+
+		string_copy_rev(entry->commit, annotation->commit);
+		entry->author = annotation->author;
+		entry->time = annotation->time;
+		line->dirty = 1;
+	}
+
+	return !string_format(key, "%s %s", state->tree_commit, view->env->directory) ||
+	       !htab_find_with_hash(tree_annotated_dirs, key, htab_hash_string(key));
+}
+
+static void
+tree_record_annotated_dir(const char *key)
+{
+	hashval_t hash = htab_hash_string(key);
+	void **slot;
+
+	if (htab_find_with_hash(tree_annotated_dirs, key, hash))
+		return;
+
+	slot = htab_find_slot_with_hash(tree_annotated_dirs, key, hash, INSERT);
+	if (slot)
+		*slot = arena_strndup(&tree_annotation_arena, key, strlen(key));
+	if (slot && !*slot)
+		htab_clear_slot(tree_annotated_dirs, slot);
+}
+
+/* Remember that all history of the directory, and thereby also of its
+ * subdirectories, has been read. */
+static void
+tree_record_annotated_dirs(struct view *view, struct tree_state *state)
+{
+	char key[SIZEOF_STR];
+	size_t i;
+
+	if (string_format(key, "%s %s", state->tree_commit, view->env->directory))
+		tree_record_annotated_dir(key);
+
+	for (i = 0; i < view->lines; i++) {
+		struct tree_entry *entry = view->line[i].data;
+
+		if (view->line[i].type == LINE_TREE_DIR && !tree_path_is_parent(entry->name) &&
+		    string_format(key, "%s %s%s/", state->tree_commit, view->env->directory, entry->name))
+			tree_record_annotated_dir(key);
+	}
+}
+
 static bool
 tree_read_date(struct view *view, char *text, struct tree_state *state)
 {
 	if (!text && state->read_date) {
+		/* Only a log which ran to the end without being stopped
+		 * early means all history has been read. */
+		if (*state->tree_commit && state->unannotated && io_eof(view->pipe))
+			tree_record_annotated_dirs(view, state);
 		state->read_date = FALSE;
 		return TRUE;
 
@@ -164,6 +407,7 @@ tree_read_date(struct view *view, char *text, struct tree_state *state)
 			"git", "log", encoding_arg, "--no-color", "--pretty=raw",
 				"--cc", "--raw", view->ops->id, "--", "%(directory)", NULL
 		};
+		bool read_log = TRUE;
 
 		if (!view->lines) {
 			tree_entry(view, LINE_TREE_HEAD, view->env->directory, NULL, NULL, 0);
@@ -172,6 +416,17 @@ tree_read_date(struct view *view, char *text, struct tree_state *state)
 			return TRUE;
 		}
 
+		if (tree_init_annotations() && tree_resolve_commit(view, state))
+			read_log = tree_apply_annotations(view, state);
+
+		if (!tree_index_entries(view, state)) {
+			report("Failed to load tree data");
+			return TRUE;
+		}
+
+		if (!read_log || !state->unannotated)
+			return TRUE;
+
 		if (!begin_update(view, repo.cdup, log_file, OPEN_EXTRA)) {
 			report("Failed to load tree data");
 			return TRUE;
@@ -188,9 +443,10 @@ tree_read_date(struct view *view, char *text, struct tree_state *state)
 				  &state->author, &state->author_time);
 
 	} else if (*text == ':') {
+		struct line *line;
+		struct tree_entry *entry;
 		char *pos;
-		size_t annotated = 1;
-		size_t i;
+		void **slot;
 
 		pos = strrchr(text, '\t');
 		if (!pos)
@@ -199,25 +455,32 @@ tree_read_date(struct view *view, char *text, struct tree_state *state)
 		if (*view->env->directory && !strncmp(text, view->env->directory, strlen(view->env->directory)))
 			text += strlen(view->env->directory);
 		pos = strchr(text, '/');
+
+		if (*state->tree_commit) {
+			tree_record_annotation(view, state, text, pos ? pos - text : strlen(text));
+			if (pos) {
+				char *subpos = strchr(pos + 1, '/');
+
+				tree_record_annotation(view, state, text, subpos ? subpos - text : strlen(text));
+			}
+		}
+
 		if (pos)
 			*pos = 0;
 
-		for (i = 1; i < view->lines; i++) {
-			struct line *line = &view->line[i];
-			struct tree_entry *entry = line->data;
-
-			annotated += !!entry->author;
-			if (entry->author || strcmp(entry->name, text))
-				continue;
+		slot = htab_find_slot_with_hash(tree_entries, text, htab_hash_string(text), NO_INSERT);
+		if (!slot)
+			return TRUE;
 
-			string_copy_rev(entry->commit, state->commit);
-			entry->author = state->author;
-			entry->time = state->author_time;
-			line->dirty = 1;
-			break;
-		}
+		line = *slot;
+		entry = line->data;
+		string_copy_rev(entry->commit, state->commit);
+		entry->author = state->author;
+		entry->time = state->author_time;
+		line->dirty = 1;
+		htab_clear_slot(tree_entries, slot);
 
-		if (annotated == view->lines)
+		if (!--state->unannotated)
 			io_kill(view->pipe);
 	}
 	return TRUE;
@@ -227,14 +490,15 @@ static bool
 tree_read(struct view *view, char *text)
 {
 	struct tree_state *state = view->private;
-	struct tree_entry *data;
-	struct line *entry, *line;
+	struct line *entry;
 	enum line_type type;
 	size_t textlen = text ? strlen(text) : 0;
 	const char *attr_offset = text + SIZEOF_TREE_ATTR;
 	char *path;
 	size_t size;
 
+	if (!text && !state->read_date)
+		tree_sort_entries(view);
 	if (state->read_date || !text)
 		return tree_read_date(view, text, state);
 
@@ -269,21 +533,6 @@ tree_read(struct view *view, char *text)
 	entry = tree_entry(view, type, path, text, text + TREE_ID_OFFSET, size);
 	if (!entry)
 		return FALSE;
-	data = entry->data;
-
-	/* Skip "Directory ..." and ".." line. */
-	for (line = &view->line[1 + !!*view->env->directory]; line < entry; line++) {
-		if (tree_compare_entry(line, entry) <= 0)
-			continue;
-
-		memmove(line + 1, line, (entry - line) * sizeof(*entry));
-
-		line->data = data;
-		line->type = type;
-		for (; line <= entry; line++)
-			line->dirty = line->cleareol = 1;
-		return TRUE;
-	}
 
 	/* Move the current line to the first tree entry. */
 	if (!check_position(&view->prev_pos) && !check_position(&view->pos))
@@ -353,6 +602,7 @@ open_blob_editor(const char *id, const char *name, unsigned int lineno)
 static enum request
 tree_request(struct view *view, enum request request, struct line *line)
 {
+	struct tree_state *state = view->private;
 	enum open_flags flags;
 	struct tree_entry *entry = line->data;
 
@@ -379,6 +629,9 @@ tree_request(struct view *view, enum request request, struct line *line)
 	case REQ_TOGGLE_SORT_FIELD:
 	case REQ_TOGGLE_SORT_ORDER:
 		sort_view(view, request, &tree_sort_state, tree_compare);
+		/* The index of entries without a date refers to lines. */
+		if (state->read_date && !tree_index_entries(view, state))
+			report("Failed to index tree entries");
 		return REQ_NONE;
 
 	case REQ_PARENT:
@@ -473,6 +726,14 @@ tree_select(struct view *view, struct line *line)
 	string_copy_rev(view->ref, entry->id);
 }
 
+static void
+tree_done(struct view *view)
+{
+	/* The indexed lines are about to be freed. */
+	if (tree_entries)
+		htab_empty(tree_entries);
+}
+
 static bool
 tree_open(struct view *view, enum open_flags flags)
 {
@@ -520,6 +781,7 @@ struct view_ops tree_ops = {
 	tree_request,
 	tree_grep,
 	tree_select,
+	tree_done,
 };
 
 /* vim: set ts=8 sw=8 noexpandtab: */
@@ -78,6 +78,7 @@ DEFINE_ENUM_MAP(file_size, FILE_SIZE_ENUM);
 DEFINE_ENUM_MAP(filename, FILENAME_ENUM);
 DEFINE_ENUM_MAP(graphic, GRAPHIC_ENUM);
 DEFINE_ENUM_MAP(ignore_space, IGNORE_SPACE_ENUM);
+DEFINE_ENUM_MAP(refresh_mode, REFRESH_MODE_ENUM);
 DEFINE_ENUM_MAP(vertical_split, VERTICAL_SPLIT_ENUM);
 
 /* vim: set ts=8 sw=8 noexpandtab: */
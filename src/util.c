@@ -256,4 +256,150 @@ mkmode(mode_t mode)
 		return "----------";
 }
 
+/*
+ * Arena allocator.
+ */
+
+#define ARENA_CHUNK_SIZE	(64 * 1024)
+#define ARENA_ALIGN(size)	(((size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+struct arena_chunk {
+	struct arena_chunk *next;
+};
+
+#define ARENA_CHUNK_HEADER	ARENA_ALIGN(sizeof(struct arena_chunk))
+
+void *
+arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_chunk *chunk;
+	size_t chunk_size;
+	void *mem;
+
+	size = ARENA_ALIGN(size ? size : 1);
+	if (arena->pos && arena->end - arena->pos >= size) {
+		mem = arena->pos;
+		arena->pos += size;
+		return mem;
+	}
+
+	/* Give large allocations their own chunk and keep filling the
+	 * current one. */
+	chunk_size = size > ARENA_CHUNK_SIZE / 4 ? size : ARENA_CHUNK_SIZE;
+	chunk = calloc(1, ARENA_CHUNK_HEADER + chunk_size);
+	if (!chunk)
+		return NULL;
+
+	mem = (char *) chunk + ARENA_CHUNK_HEADER;
+	if (chunk_size != size || !arena->chunks) {
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		arena->pos = (char *) mem + size;
+		arena->end = (char *) mem + chunk_size;
+	} else {
+		chunk->next = arena->chunks->next;
+		arena->chunks->next = chunk;
+	}
+
+	return mem;
+}
+
+char *
+arena_strndup(struct arena *arena, const char *str, size_t len)
+{
+	char *copy = arena_alloc(arena, len + 1);
+
+	if (copy)
+		memcpy(copy, str, len);
+	return copy;
+}
+
+void
+arena_free(struct arena *arena)
+{
+	struct arena_chunk *chunk = arena->chunks;
+
+	while (chunk) {
+		struct arena_chunk *next = chunk->next;
+
+		free(chunk);
+		chunk = next;
+	}
+
+	memset(arena, 0, sizeof(*arena));
+}
+
+/*
+ * String interning.
+ */
+
+struct string_pool_key {
+	const char *str;
+	size_t len;
+};
+
+/* Same as htab_hash_string(), but for strings that are not NUL
+ * terminated. */
+static hashval_t
+string_pool_hash_key(const char *str, size_t len)
+{
+	hashval_t hash = 0;
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		hash = hash * 67 + (unsigned char) str[i] - 113;
+	return hash;
+}
+
+static hashval_t
+string_pool_hash(const void *entry)
+{
+	return string_pool_hash_key(entry, strlen(entry));
+}
+
+static int
+string_pool_eq(const void *entry, const void *key_)
+{
+	const struct string_pool_key *key = key_;
+	const char *str = entry;
+
+	return !strncmp(str, key->str, key->len) && !str[key->len];
+}
+
+const char *
+string_pool_intern(struct string_pool *pool, const char *str, size_t len)
+{
+	struct string_pool_key key = { str, len };
+	hashval_t hash = string_pool_hash_key(str, len);
+	char *entry;
+	void **slot;
+
+	if (!pool->map) {
+		pool->map = htab_create_alloc(1024, string_pool_hash, string_pool_eq, NULL, calloc, free);
+		if (!pool->map)
+			return NULL;
+	}
+
+	entry = htab_find_with_hash(pool->map, &key, hash);
+	if (entry)
+		return entry;
+
+	entry = arena_strndup(&pool->arena, str, len);
+	slot = entry ? htab_find_slot_with_hash(pool->map, &key, hash, INSERT) : NULL;
+	if (!slot)
+		return NULL;
+
+	*slot = entry;
+	return entry;
+}
+
+void
+string_pool_free(struct string_pool *pool)
+{
+	if (pool->map)
+		htab_delete(pool->map);
+	arena_free(&pool->arena);
+	memset(pool, 0, sizeof(*pool));
+}
+
 /* vim: set ts=8 sw=8 noexpandtab: */
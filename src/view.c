@@ -430,17 +430,27 @@ reset_view_history(struct view_history *history)
  * Incremental updating
  */
 
+DEFINE_ALLOCATOR(realloc_line_ids, struct line_id, 256)
+
+static void
+reset_line_ids(struct view *view)
+{
+	free(view->ids);
+	view->ids = NULL;
+	view->ids_size = 0;
+	view->ids_lines = 0;
+}
+
 void
 reset_view(struct view *view)
 {
-	int i;
-
 	if (view->ops->done)
 		view->ops->done(view);
 
-	for (i = 0; i < view->lines; i++)
-		free(view->line[i].data);
+	arena_free(&view->arena);
 	free(view->line);
+	view->line_alloc = 0;
+	reset_line_ids(view);
 
 	view->prev_pos = view->pos;
 	clear_position(&view->pos);
@@ -500,7 +510,12 @@ end_update(struct view *view, bool force)
 static void
 setup_update(struct view *view, const char *vid)
 {
+	/* Reloading the same content will most likely yield the same
+	 * number of lines, so use it as a hint for the new line index. */
+	size_t lines = !strcmp(view->vid, vid) ? view->lines : 0;
+
 	reset_view(view);
+	reserve_view_lines(view, lines);
 	/* XXX: Do not use string_copy_rev(), it copies until first space. */
 	string_ncopy(view->vid, vid, strlen(vid));
 	view->pipe = &view->io;
@@ -556,6 +571,11 @@ begin_update(struct view *view, const char *dir, const char **argv, enum open_fl
 			die("Failed to open stdin");
 	}
 
+	/* Read text straight into the view's memory so lines can be added
+	 * without copying them. */
+	if (view_has_flags(view, VIEW_KEEP_TEXT))
+		view->io.arena = &view->arena;
+
 	if (!extra)
 		setup_update(view, view->ops->id);
 
@@ -565,12 +585,19 @@ begin_update(struct view *view, const char *dir, const char **argv, enum open_fl
 bool
 update_view(struct view *view)
 {
-	char *line;
+	struct buffer buf;
 	/* Clear the view and redraw everything since the tree sorting
 	 * might have rearranged things. */
 	bool redraw = view->lines == 0;
 	bool can_read = TRUE;
 	struct encoding *encoding = view->encoding ? view->encoding : default_encoding;
+	int separator = '\n';
+
+	/* NUL separated output lists paths, which are not converted. */
+	if (view_has_flags(view, VIEW_NUL_SEPARATED)) {
+		encoding = NULL;
+		separator = 0;
+	}
 
 	if (!view->pipe)
 		return TRUE;
@@ -589,16 +616,24 @@ update_view(struct view *view)
 		return TRUE;
 	}
 
-	for (; (line = io_get(view->pipe, '\n', can_read)); can_read = FALSE) {
+	for (; io_get_buffer(view->pipe, &buf, separator, can_read); can_read = FALSE) {
+		char *line = buf.data;
+
 		if (encoding) {
 			line = encoding_convert(encoding, line);
 		}
 
+		/* Converted lines live in a static buffer and must be copied. */
+		if (view->pipe->arena && line == buf.data)
+			view->read = buf;
+
 		if (!view->ops->read(view, line)) {
 			report("Allocation failure");
 			end_update(view, TRUE);
 			return FALSE;
 		}
+
+		view->read.data = NULL;
 	}
 
 	if (!view_has_flags(view, VIEW_CUSTOM_DIGITS)) {
@@ -638,6 +673,20 @@ update_view(struct view *view)
 	return TRUE;
 }
 
+/* Wait for the remaining view content to be loaded, for when the caller
+ * depends on the view being complete. */
+bool
+complete_update(struct view *view)
+{
+	while (view->pipe) {
+		io_can_read(view->pipe, TRUE);
+		if (!update_view(view))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
 void
 update_view_title(struct view *view)
 {
@@ -734,6 +783,8 @@ load_view(struct view *view, struct view *prev, enum open_flags flags)
 			memset(view->private, 0, view->ops->private_size);
 	}
 
+	view->watch.changed = WATCH_NONE;
+
 	/* When prev == view it means this is the first loaded view. */
 	if (prev && view != prev) {
 		view->prev = prev;
@@ -829,6 +880,7 @@ sort_view(struct view *view, enum request request, struct sort_state *state,
 	}
 
 	qsort(view->line, view->lines, sizeof(*view->line), compare);
+	reset_line_ids(view);
 	redraw_view(view);
 }
 
@@ -842,11 +894,131 @@ find_line_by_type(struct view *view, struct line *line, enum line_type type, int
 	return NULL;
 }
 
+static int
+compare_line_ids(const void *l1, const void *l2)
+{
+	const struct line_id *id1 = l1;
+	const struct line_id *id2 = l2;
+	int cmp = strcmp(id1->id, id2->id);
+
+	if (cmp)
+		return cmp;
+	return id1->lineno < id2->lineno ? -1 : id1->lineno > id2->lineno;
+}
+
+/* Extend the ID index with lines added since it was last used. The new
+ * entries are sorted separately and merged with the already sorted ones,
+ * so an index that is queried while loading stays cheap to maintain. */
+static bool
+update_line_ids(struct view *view, const char *(*get_id)(struct line *line))
+{
+	struct line_id *sorted_ids;
+	size_t sorted, i, j, k;
+
+	/* Lines were removed from the end of the view. */
+	if (view->ids_lines > view->lines)
+		reset_line_ids(view);
+
+	sorted = view->ids_size;
+
+	for (; view->ids_lines < view->lines; view->ids_lines++) {
+		const char *id = get_id(&view->line[view->ids_lines]);
+
+		if (!id || !*id)
+			continue;
+		if (!realloc_line_ids(&view->ids, view->ids_size, 1))
+			return FALSE;
+		view->ids[view->ids_size].id = id;
+		view->ids[view->ids_size++].lineno = view->ids_lines;
+	}
+
+	if (sorted == view->ids_size)
+		return TRUE;
+
+	qsort(view->ids + sorted, view->ids_size - sorted, sizeof(*view->ids), compare_line_ids);
+	if (!sorted)
+		return TRUE;
+
+	sorted_ids = malloc(sorted * sizeof(*sorted_ids));
+	if (!sorted_ids)
+		return FALSE;
+	memcpy(sorted_ids, view->ids, sorted * sizeof(*sorted_ids));
+
+	/* Merge from the front; the write position never passes the read
+	 * position of the new entries. */
+	for (i = 0, j = sorted, k = 0; i < sorted; k++) {
+		if (j < view->ids_size && compare_line_ids(&view->ids[j], &sorted_ids[i]) < 0)
+			view->ids[k] = view->ids[j++];
+		else
+			view->ids[k] = sorted_ids[i++];
+	}
+
+	free(sorted_ids);
+	return TRUE;
+}
+
+/* Find the first line having an ID starting with the given prefix. The
+ * IDs are expected to be lowercase, the prefix is matched ignoring case. */
+struct line *
+find_line_by_id(struct view *view, const char *prefix, const char *(*get_id)(struct line *line))
+{
+	char id[SIZEOF_STR];
+	size_t idlen = strlen(prefix);
+	size_t first = 0, last, pos;
+	struct line *line = NULL;
+
+	if (idlen >= sizeof(id) || !update_line_ids(view, get_id))
+		return NULL;
+
+	for (pos = 0; pos < idlen; pos++)
+		id[pos] = tolower(prefix[pos]);
+	id[idlen] = 0;
+
+	for (last = view->ids_size; first < last; ) {
+		pos = first + (last - first) / 2;
+		if (strcmp(view->ids[pos].id, id) < 0)
+			first = pos + 1;
+		else
+			last = pos;
+	}
+
+	for (pos = first; pos < view->ids_size && !strncmp(view->ids[pos].id, id, idlen); pos++) {
+		struct line *match = &view->line[view->ids[pos].lineno];
+
+		if (!line || match < line)
+			line = match;
+	}
+
+	return line;
+}
+
 /*
  * Line utilities.
  */
 
-DEFINE_ALLOCATOR(realloc_lines, struct line, 256)
+/* Make room for adding the given number of lines without reallocating
+ * the line index. The index is grown geometrically. */
+bool
+reserve_view_lines(struct view *view, size_t lines)
+{
+	size_t size = view->lines + lines;
+	size_t alloc = view->line_alloc ? view->line_alloc : 256;
+	struct line *tmp;
+
+	if (size <= view->line_alloc)
+		return TRUE;
+
+	while (alloc < size)
+		alloc *= 2;
+
+	tmp = realloc(view->line, alloc * sizeof(*view->line));
+	if (!tmp)
+		return FALSE;
+
+	view->line = tmp;
+	view->line_alloc = alloc;
+	return TRUE;
+}
 
 struct line *
 add_line_at(struct view *view, unsigned long pos, const void *data, enum line_type type, size_t data_size, bool custom)
@@ -854,11 +1026,11 @@ add_line_at(struct view *view, unsigned long pos, const void *data, enum line_ty
 	struct line *line;
 	unsigned long lineno;
 
-	if (!realloc_lines(&view->line, view->lines, 1))
+	if (!reserve_view_lines(view, 1))
 		return NULL;
 
 	if (data_size) {
-		void *alloc_data = calloc(1, data_size);
+		void *alloc_data = arena_alloc(&view->arena, data_size);
 
 		if (!alloc_data)
 			return NULL;
@@ -869,6 +1041,7 @@ add_line_at(struct view *view, unsigned long pos, const void *data, enum line_ty
 	}
 
 	if (pos < view->lines) {
+		reset_line_ids(view);
 		view->lines++;
 		line = view->line + pos;
 		lineno = line->lineno;
@@ -921,6 +1094,9 @@ add_line_nodata(struct view *view, enum line_type type)
 struct line *
 add_line_text(struct view *view, const char *text, enum line_type type)
 {
+	/* The line being read is already in the view's arena. */
+	if (text == view->read.data)
+		return add_line(view, text, type, 0, FALSE);
 	return add_line(view, text, type, strlen(text) + 1, FALSE);
 }
 
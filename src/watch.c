@@ -0,0 +1,673 @@
+/* Copyright (c) 2006-2014 Jonas Fonseca <jonas.fonseca@gmail.com>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+
+#include "tig/tig.h"
+#include "tig/util.h"
+#include "tig/argv.h"
+#include "tig/repo.h"
+#include "tig/options.h"
+#include "tig/watch.h"
+
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#include "compat/hashtab.h"
+#endif
+
+/*
+ * Directory watching.
+ */
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+struct watch_tree {
+	int fd;
+	char root[SIZEOF_STR];	/* Directory being watched. */
+	char **dirs;		/* Watched directories indexed by descriptor. */
+	size_t dirs_size;
+};
+
+#define WATCH_TREE_INIT { -1 }
+
+DEFINE_ALLOCATOR(realloc_watch_dirs, char *, 256)
+
+static bool
+watch_tree_open(struct watch_tree *tree, const char *root)
+{
+	if (!string_format(tree->root, "%s", *root ? root : "./"))
+		return FALSE;
+	tree->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	return tree->fd != -1;
+}
+
+static void
+watch_tree_close(struct watch_tree *tree)
+{
+	size_t i;
+
+	if (tree->fd != -1)
+		close(tree->fd);
+	tree->fd = -1;
+
+	for (i = 0; i < tree->dirs_size; i++)
+		free(tree->dirs[i]);
+	free(tree->dirs);
+	tree->dirs = NULL;
+	tree->dirs_size = 0;
+}
+
+/* Watch a directory relative to the root, and optionally all directories
+ * below it except those named ".git". */
+static bool
+watch_tree_add(struct watch_tree *tree, const char *path, uint32_t mask, bool recursive)
+{
+	char buf[SIZEOF_STR];
+	struct dirent *entry;
+	DIR *dir;
+	int wd;
+
+	if (!string_format(buf, "%s%s", tree->root, path))
+		return FALSE;
+
+	wd = inotify_add_watch(tree->fd, buf, mask | IN_ONLYDIR | IN_DONT_FOLLOW);
+	if (wd < 0)
+		/* The directory might have been removed already. */
+		return errno == ENOENT || errno == ENOTDIR;
+
+	if (wd >= tree->dirs_size) {
+		if (!realloc_watch_dirs(&tree->dirs, tree->dirs_size, wd + 1 - tree->dirs_size))
+			return FALSE;
+		tree->dirs_size = wd + 1;
+	}
+
+	free(tree->dirs[wd]);
+	tree->dirs[wd] = strdup(path);
+	if (!tree->dirs[wd])
+		return FALSE;
+
+	if (!recursive || !(dir = opendir(buf)))
+		return TRUE;
+
+	while ((entry = readdir(dir))) {
+		char subdir[SIZEOF_STR];
+		struct stat st;
+
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..") ||
+		    !strcmp(entry->d_name, ".git"))
+			continue;
+
+		if (!string_format(subdir, "%s%s/", path, entry->d_name))
+			break;
+
+		if (entry->d_type == DT_UNKNOWN) {
+			if (!string_format(buf, "%s%s", tree->root, subdir) ||
+			    lstat(buf, &st) < 0 || !S_ISDIR(st.st_mode))
+				continue;
+		} else if (entry->d_type != DT_DIR) {
+			continue;
+		}
+
+		if (!watch_tree_add(tree, subdir, mask, TRUE))
+			break;
+	}
+
+	closedir(dir);
+	return entry == NULL;
+}
+
+/* Read all pending events and pass them on together with the directory
+ * they happened in. Events for unknown directories are skipped. */
+static void
+watch_tree_read(struct watch_tree *tree,
+		void (*read_event)(struct inotify_event *event, const char *dir))
+{
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	ssize_t size;
+
+	while ((size = read(tree->fd, buf, sizeof(buf))) > 0) {
+		char *pos;
+
+		for (pos = buf; pos < buf + size; ) {
+			struct inotify_event *event = (struct inotify_event *) pos;
+			const char *dir = event->wd >= 0 && event->wd < tree->dirs_size
+					? tree->dirs[event->wd] : NULL;
+
+			if (dir || (event->mask & IN_Q_OVERFLOW))
+				read_event(event, dir);
+
+			if (dir && (event->mask & IN_IGNORED)) {
+				free(tree->dirs[event->wd]);
+				tree->dirs[event->wd] = NULL;
+			}
+
+			pos += sizeof(*event) + event->len;
+		}
+	}
+}
+
+#endif
+
+/*
+ * Working tree change tracking.
+ */
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+#define WATCH_WORKTREE_EVENTS \
+	(IN_ATTRIB | IN_CLOSE_WRITE | IN_MODIFY | IN_CREATE | IN_DELETE | \
+	 IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF)
+
+static struct {
+	struct watch_tree tree;
+	const char **paths;	/* Paths changed since the last reset. */
+	size_t paths_size;
+	htab_t seen;		/* Changed paths indexed by name. */
+	bool failed;		/* Watching is not possible, stop trying. */
+	bool lost;		/* Changes were missed. */
+	bool stale;		/* Paths of watched directories have changed. */
+} worktree = { WATCH_TREE_INIT };
+
+static int
+watch_path_eq(const void *entry, const void *element)
+{
+	return !strcmp(entry, element);
+}
+
+static void
+watch_add_path(const char *path)
+{
+	void **slot;
+
+	if (worktree.lost)
+		return;
+
+	if (worktree.paths_size >= WATCH_MAX_PATHS) {
+		worktree.lost = TRUE;
+		return;
+	}
+
+	slot = htab_find_slot_with_hash(worktree.seen, path, htab_hash_string(path), INSERT);
+	if (!slot) {
+		worktree.lost = TRUE;
+	} else if (!*slot) {
+		if (!argv_append(&worktree.paths, path))
+			worktree.lost = TRUE;
+		else
+			*slot = (void *) worktree.paths[worktree.paths_size++];
+	}
+}
+
+static void
+watch_read_worktree_event(struct inotify_event *event, const char *dir)
+{
+	char path[SIZEOF_STR];
+
+	if (event->mask & IN_Q_OVERFLOW) {
+		worktree.lost = TRUE;
+		return;
+	}
+
+	if (event->mask & IN_IGNORED)
+		return;
+
+	/* Events for the directory itself are also reported by its
+	 * parent, except for the top directory. */
+	if (!event->len) {
+		if (!*dir && (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)))
+			worktree.lost = worktree.stale = TRUE;
+		return;
+	}
+
+	if (!strcmp(event->name, ".git"))
+		return;
+
+	if (!string_format(path, "%s%s", dir, event->name)) {
+		worktree.lost = TRUE;
+		return;
+	}
+
+	if (event->mask & IN_ISDIR) {
+		/* Paths of directories moved within the tree are stale. */
+		if (event->mask & IN_MOVED_FROM)
+			worktree.lost = worktree.stale = TRUE;
+
+		if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+			char subdir[SIZEOF_STR];
+
+			if (!string_format(subdir, "%s/", path) ||
+			    !watch_tree_add(&worktree.tree, subdir, WATCH_WORKTREE_EVENTS, TRUE))
+				worktree.lost = worktree.stale = TRUE;
+		}
+	}
+
+	watch_add_path(path);
+}
+
+static void
+watch_forget_changes(void)
+{
+	argv_free(worktree.paths);
+	worktree.paths_size = 0;
+	if (worktree.seen)
+		htab_empty(worktree.seen);
+	worktree.lost = worktree.stale = FALSE;
+}
+
+void
+watch_worktree_stop(void)
+{
+	watch_tree_close(&worktree.tree);
+	watch_forget_changes();
+	free(worktree.paths);
+	worktree.paths = NULL;
+	if (worktree.seen)
+		htab_delete(worktree.seen);
+	worktree.seen = NULL;
+}
+
+/* Start watching all directories below the given directory. Gives up
+ * for good if the directories cannot all be watched, e.g. when running
+ * out of inotify watches on a huge working tree. */
+bool
+watch_worktree(const char *dir)
+{
+	if (worktree.tree.fd != -1)
+		return TRUE;
+	if (worktree.failed)
+		return FALSE;
+
+	if (!(worktree.seen = htab_create_alloc(64, htab_hash_string, watch_path_eq, NULL, calloc, free)) ||
+	    !watch_tree_open(&worktree.tree, dir) ||
+	    !watch_tree_add(&worktree.tree, "", WATCH_WORKTREE_EVENTS, TRUE)) {
+		watch_worktree_stop();
+		worktree.failed = TRUE;
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Get the paths changed since the last reset, relative to the watched
+ * directory, or NULL if changes could not be tracked. */
+const char **
+watch_worktree_changes(void)
+{
+	static const char *no_paths[] = { NULL };
+
+	if (worktree.tree.fd == -1)
+		return NULL;
+
+	watch_tree_read(&worktree.tree, watch_read_worktree_event);
+	if (worktree.lost)
+		return NULL;
+	return worktree.paths ? worktree.paths : no_paths;
+}
+
+/* Forget about all changes. Start over if paths have become stale. */
+void
+watch_worktree_reset(void)
+{
+	char root[SIZEOF_STR];
+
+	if (worktree.tree.fd == -1)
+		return;
+
+	if (worktree.stale) {
+		string_copy(root, worktree.tree.root);
+		watch_worktree_stop();
+		watch_worktree(root);
+		return;
+	}
+
+	watch_forget_changes();
+}
+
+#else
+
+bool
+watch_worktree(const char *dir)
+{
+	return FALSE;
+}
+
+const char **
+watch_worktree_changes(void)
+{
+	return NULL;
+}
+
+void
+watch_worktree_reset(void)
+{
+}
+
+void
+watch_worktree_stop(void)
+{
+}
+
+#endif
+
+/*
+ * Repository change tracking.
+ */
+
+#define WATCH_DELAY		300	/* Milliseconds without changes before refreshing. */
+#define WATCH_POLL_INTERVAL	1000	/* Milliseconds between checking files. */
+
+static struct watch *watches;
+
+static struct {
+	bool started;
+	int fd;				/* Change notifications, or -1 if polling. */
+	enum watch_trigger pending;	/* Changes not yet passed on to watches. */
+	unsigned long changed;		/* Time of the last pending change. */
+	unsigned long polled;		/* Time files were last checked. */
+	unsigned long state[WATCH_TRIGGERS];	/* Checked file information. */
+} repo_watch = { FALSE, -1 };
+
+static unsigned long
+watch_time(void)
+{
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+void
+watch_register(struct watch *watch, enum watch_trigger triggers)
+{
+	struct watch *pos;
+
+	for (pos = watches; pos && pos != watch; pos = pos->next)
+		;
+	if (!pos) {
+		watch->next = watches;
+		watches = watch;
+	}
+
+	watch->triggers = triggers;
+	watch->changed = WATCH_NONE;
+}
+
+bool
+watch_dirty(struct watch *watch)
+{
+	return !!(watch->changed & watch->triggers);
+}
+
+static void
+watch_repo_changed(enum watch_trigger triggers)
+{
+	if (!triggers)
+		return;
+	repo_watch.pending |= triggers;
+	repo_watch.changed = watch_time();
+}
+
+/* Get the changes a file in the repository directory can cause. Lock
+ * files are ignored, since they are renamed once the update is done. */
+static enum watch_trigger
+watch_repo_triggers(const char *path)
+{
+	size_t pathlen = strlen(path);
+
+	if (pathlen >= STRING_SIZE(".lock") &&
+	    !strcmp(path + pathlen - STRING_SIZE(".lock"), ".lock"))
+		return WATCH_NONE;
+	if (!strcmp(path, "HEAD") || !strcmp(path, "MERGE_HEAD"))
+		return WATCH_HEAD;
+	if (!strcmp(path, "index"))
+		return WATCH_INDEX;
+	if (!strcmp(path, "packed-refs"))
+		return WATCH_REFS;
+	/* The branch of HEAD might have been updated. */
+	if (!prefixcmp(path, "refs/heads/"))
+		return WATCH_REFS | WATCH_HEAD;
+	if (!prefixcmp(path, "refs/"))
+		return WATCH_REFS;
+	return WATCH_NONE;
+}
+
+/*
+ * Polling for changes by checking the modification time of files. Refs
+ * are renamed into place when updated, which also changes the
+ * modification time of the directory containing them.
+ */
+
+static unsigned long
+watch_stat_hash(unsigned long hash, const char *path)
+{
+	char buf[SIZEOF_STR];
+	struct stat st;
+
+	if (!string_format(buf, "%s/%s", repo.git_dir, path) || stat(buf, &st) < 0)
+		return hash * 31;
+
+	hash = hash * 31 + st.st_ino;
+	hash = hash * 31 + st.st_size;
+	hash = hash * 31 + st.st_mtime;
+	return hash * 31 + st.st_ctime;
+}
+
+static unsigned long
+watch_stat_dirs(unsigned long hash, const char *path)
+{
+	char buf[SIZEOF_STR];
+	struct dirent *entry;
+	DIR *dir;
+
+	hash = watch_stat_hash(hash, path);
+	if (!string_format(buf, "%s/%s", repo.git_dir, path) || !(dir = opendir(buf)))
+		return hash;
+
+	while ((entry = readdir(dir))) {
+		char subdir[SIZEOF_STR];
+		struct stat st;
+
+		if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, "..") ||
+		    !string_format(subdir, "%s/%s", path, entry->d_name) ||
+		    !string_format(buf, "%s/%s", repo.git_dir, subdir) ||
+		    stat(buf, &st) < 0 || !S_ISDIR(st.st_mode))
+			continue;
+		hash = watch_stat_dirs(hash, subdir);
+	}
+
+	closedir(dir);
+	return hash;
+}
+
+static void
+watch_repo_poll(void)
+{
+	unsigned long state[WATCH_TRIGGERS];
+	enum watch_trigger triggers = WATCH_NONE;
+	int i;
+
+	/* Indexed by the bit number of each trigger. */
+	state[0] = watch_stat_hash(watch_stat_hash(0, "HEAD"), "MERGE_HEAD");
+	state[0] = watch_stat_dirs(state[0], "refs/heads");
+	state[1] = watch_stat_hash(0, "index");
+	state[2] = watch_stat_dirs(watch_stat_hash(0, "packed-refs"), "refs");
+
+	for (i = 0; i < WATCH_TRIGGERS; i++)
+		if (repo_watch.polled && state[i] != repo_watch.state[i])
+			triggers |= 1 << i;
+
+	memcpy(repo_watch.state, state, sizeof(state));
+	repo_watch.polled = watch_time();
+	watch_repo_changed(triggers);
+}
+
+#ifdef HAVE_SYS_INOTIFY_H
+
+#define WATCH_REPO_EVENTS \
+	(IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
+
+static struct watch_tree repo_tree = WATCH_TREE_INIT;
+
+static void
+watch_read_repo_event(struct inotify_event *event, const char *dir)
+{
+	char path[SIZEOF_STR];
+
+	/* Assume everything has changed. */
+	if (event->mask & IN_Q_OVERFLOW) {
+		watch_repo_changed(WATCH_HEAD | WATCH_INDEX | WATCH_REFS);
+		return;
+	}
+
+	if (!event->len || !string_format(path, "%s%s", dir, event->name))
+		return;
+
+	if (*dir && (event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO))) {
+		char subdir[SIZEOF_STR];
+
+		if (string_format(subdir, "%s/", path))
+			watch_tree_add(&repo_tree, subdir, WATCH_REPO_EVENTS, TRUE);
+	}
+
+	watch_repo_changed(watch_repo_triggers(path));
+}
+
+static bool
+watch_repo_open(void)
+{
+	char root[SIZEOF_STR];
+
+	if (!string_format(root, "%s/", repo.git_dir) ||
+	    !watch_tree_open(&repo_tree, root) ||
+	    !watch_tree_add(&repo_tree, "", WATCH_REPO_EVENTS, FALSE) ||
+	    !watch_tree_add(&repo_tree, "refs/", WATCH_REPO_EVENTS, TRUE)) {
+		watch_tree_close(&repo_tree);
+		return FALSE;
+	}
+
+	repo_watch.fd = repo_tree.fd;
+	return TRUE;
+}
+
+static void
+watch_repo_read(void)
+{
+	watch_tree_read(&repo_tree, watch_read_repo_event);
+}
+
+static void
+watch_repo_close(void)
+{
+	watch_tree_close(&repo_tree);
+}
+
+#else
+
+static bool
+watch_repo_open(void)
+{
+	return FALSE;
+}
+
+static void
+watch_repo_read(void)
+{
+}
+
+static void
+watch_repo_close(void)
+{
+}
+
+#endif
+
+/* Start or stop watching the repository depending on the refresh mode.
+ * Files are checked periodically when notifications are not available. */
+static bool
+watch_repo_start(void)
+{
+	bool enabled = opt_refresh_mode == REFRESH_MODE_AUTO && *repo.git_dir;
+
+	if (enabled == repo_watch.started)
+		return enabled;
+
+	repo_watch.fd = -1;
+	repo_watch.pending = WATCH_NONE;
+	repo_watch.polled = 0;
+	repo_watch.started = enabled;
+
+	if (!enabled)
+		watch_repo_close();
+	else if (!watch_repo_open())
+		watch_repo_poll();
+
+	return enabled;
+}
+
+/* Get what to wait for before calling watch_update(): a descriptor to
+ * poll and a timeout in milliseconds, which are -1 if not needed. Returns
+ * FALSE if the repository is not being watched. */
+bool
+watch_wait(int *fd, int *timeout)
+{
+	unsigned long now, deadline;
+
+	if (!watch_repo_start())
+		return FALSE;
+
+	*fd = repo_watch.fd;
+	*timeout = -1;
+
+	if (repo_watch.pending)
+		deadline = repo_watch.changed + WATCH_DELAY;
+	else if (repo_watch.fd == -1)
+		deadline = repo_watch.polled + WATCH_POLL_INTERVAL;
+	else
+		return TRUE;
+
+	now = watch_time();
+	*timeout = deadline > now ? deadline - now : 0;
+	return TRUE;
+}
+
+/* Check for changes and once they have settled mark the watches, which
+ * depend on them. Returns TRUE if any watch was marked. */
+bool
+watch_update(void)
+{
+	enum watch_trigger pending;
+	struct watch *watch;
+	bool changed = FALSE;
+
+	if (!watch_repo_start())
+		return FALSE;
+
+	if (repo_watch.fd != -1)
+		watch_repo_read();
+	else if (watch_time() >= repo_watch.polled + WATCH_POLL_INTERVAL)
+		watch_repo_poll();
+
+	pending = repo_watch.pending;
+	if (!pending || watch_time() < repo_watch.changed + WATCH_DELAY)
+		return FALSE;
+
+	for (watch = watches; watch; watch = watch->next) {
+		if (watch->triggers & pending) {
+			watch->changed |= watch->triggers & pending;
+			changed = TRUE;
+		}
+	}
+
+	repo_watch.pending = WATCH_NONE;
+	return changed;
+}
+
+/* vim: set ts=8 sw=8 noexpandtab: */
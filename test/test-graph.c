@@ -33,6 +33,7 @@ DEFINE_ALLOCATOR(realloc_commits, struct commit *, 8)
 int
 main(int argc, const char *argv[])
 {
+	struct arena arena = { };
 	struct graph graph = { };
 	struct io io = { };
 	char *line;
@@ -40,7 +41,7 @@ main(int argc, const char *argv[])
 	size_t ncommits = 0;
 	struct commit *commit = NULL;
 	bool is_boundary;
-	const char *(*graph_fn)(struct graph_symbol *) = graph_symbol_to_utf8;
+	const char *(*graph_fn)(const struct graph_symbol *) = graph_symbol_to_utf8;
 
 	if (argc > 1 && !strcmp(argv[1], "--ascii"))
 		graph_fn = graph_symbol_to_ascii;
@@ -52,6 +53,8 @@ main(int argc, const char *argv[])
 	if (!io_open(&io, "%s", ""))
 		die("IO");
 
+	graph.arena = &arena;
+
 	while (!io_eof(&io)) {
 		bool can_read = io_can_read(&io, TRUE);
 
@@ -81,7 +84,7 @@ main(int argc, const char *argv[])
 					continue;
 
 				for (i = 0; i < commit->canvas.size; i++) {
-					struct graph_symbol *symbol = &commit->canvas.symbols[i];
+					const struct graph_symbol *symbol = &commit->canvas.symbols[i];
 					const char *chars = graph_fn(symbol);
 
 					printf("%s", chars + (i == 0));